@@ -27,3 +27,7 @@ void ga_component::update(ga_frame_params* params)
 void ga_component::late_update(ga_frame_params* params)
 {
 }
+
+void ga_component::draw(ga_frame_params* params)
+{
+}
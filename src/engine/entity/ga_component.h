@@ -26,6 +26,10 @@ public:
 	virtual void update(struct ga_frame_params* params);
 	virtual void late_update(struct ga_frame_params* params);
 
+	// Emits drawcalls for the entity as it is now. Must not change any state,
+	// the entity may be showing a blend between two simulation ticks.
+	virtual void draw(struct ga_frame_params* params);
+
 	const class ga_entity* get_entity() const { return _entity; }
 	class ga_entity* get_entity() { return _entity; }
 
@@ -40,6 +40,14 @@ void ga_entity::late_update(ga_frame_params* params)
 	}
 }
 
+void ga_entity::draw(ga_frame_params* params)
+{
+	for (auto& c : _components)
+	{
+		c->draw(params);
+	}
+}
+
 void ga_entity::translate(const ga_vec3f& translation)
 {
 	_transform.translate(translation);
@@ -29,6 +29,7 @@ public:
 
 	void update(struct ga_frame_params* params);
 	void late_update(struct ga_frame_params* params);
+	void draw(struct ga_frame_params* params);
 
 	void translate(const struct ga_vec3f& translation);
 	void rotate(const struct ga_quatf& rotation);
@@ -28,3 +28,12 @@
 #if defined(__MINGW32__)
 #define GA_32_BIT
 #endif
+
+// Instruction sets.
+#if defined(__AVX2__)
+#define GA_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GA_SSE2
+#endif
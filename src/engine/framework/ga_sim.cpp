@@ -104,3 +104,70 @@ void ga_sim::late_update(ga_frame_params* params)
 	ga_job::run(decls, int(_entities.size()), &update_counter);
 	ga_job::wait(&update_counter);
 }
+
+void ga_sim::draw(ga_frame_params* params)
+{
+	auto decls = static_cast<ga_job_decl_t*>(alloca(sizeof(ga_job_decl_t) * _entities.size()));
+
+	struct draw_data_t
+	{
+		ga_entity* _entity;
+		ga_frame_params* _params;
+	};
+	auto draw_data = static_cast<draw_data_t*>(alloca(sizeof(draw_data_t) * _entities.size()));
+
+	for (int i = 0; i < int(_entities.size()); ++i)
+	{
+		draw_data[i]._entity = _entities[i];
+		draw_data[i]._params = params;
+
+		decls[i]._data = draw_data + i;
+		decls[i]._entry = [](void* data)
+		{
+			auto draw_data = static_cast<draw_data_t*>(data);
+			draw_data->_entity->draw(draw_data->_params);
+		};
+	}
+
+	int32_t draw_counter;
+	ga_job::run(decls, int(_entities.size()), &draw_counter);
+	ga_job::wait(&draw_counter);
+}
+
+void ga_sim::save_tick_state()
+{
+	_previous_transforms.resize(_entities.size());
+	for (int i = 0; i < int(_entities.size()); ++i)
+	{
+		_previous_transforms[i] = _entities[i]->get_transform();
+	}
+}
+
+void ga_sim::begin_interpolation(float alpha)
+{
+	// Entities added since the last tick have no previous state and render as-is.
+	_current_transforms.resize(_entities.size());
+	for (int i = 0; i < int(_entities.size()); ++i)
+	{
+		const ga_mat4f& current = _entities[i]->get_transform();
+		_current_transforms[i] = current;
+		if (i >= int(_previous_transforms.size()))
+		{
+			continue;
+		}
+
+		const ga_mat4f& previous = _previous_transforms[i];
+		ga_mat4f blended;
+		blended.make_rotation(ga_quatf_nlerp(previous.get_rotation(), current.get_rotation(), alpha));
+		blended.set_translation(ga_vec3f_lerp(previous.get_translation(), current.get_translation(), alpha));
+		_entities[i]->set_transform(blended);
+	}
+}
+
+void ga_sim::end_interpolation()
+{
+	for (int i = 0; i < int(_current_transforms.size()); ++i)
+	{
+		_entities[i]->set_transform(_current_transforms[i]);
+	}
+}
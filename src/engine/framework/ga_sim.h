@@ -9,6 +9,8 @@
 ** This file is distributed under the MIT License. See LICENSE.txt.
 */
 
+#include "math/ga_mat4f.h"
+
 #include <vector>
 
 /*
@@ -27,6 +29,19 @@ public:
 	void update(struct ga_frame_params* params);
 	void late_update(struct ga_frame_params* params);
 
+	// Emits every entity's drawcalls without changing any state.
+	void draw(struct ga_frame_params* params);
+
+	// Render interpolation between the last two fixed simulation ticks.
+	// Call save_tick_state() before each tick, then wrap draw() in
+	// begin_interpolation()/end_interpolation().
+	void save_tick_state();
+	void begin_interpolation(float alpha);
+	void end_interpolation();
+
 private:
 	std::vector<class ga_entity*> _entities;
+
+	std::vector<ga_mat4f> _previous_transforms;
+	std::vector<ga_mat4f> _current_transforms;
 };
@@ -1,19 +1,33 @@
 #include "ga_sim.h"
 #include "ga_snapshot.h"
-#include "network/ga_socket.h" // For MAX_BUFFER
+#include "ga_compiler_defines.h"
+#include "network/ga_bitstream.h"
+
+#if defined(GA_AVX2)
+#include <immintrin.h>
+#elif defined(GA_SSE2)
+#include <emmintrin.h>
+#endif
+
+#if defined(GA_MSVC)
+#include <intrin.h>
+#endif
+
+ga_quantization ga_snapshot::_quantization;
+
+static uint32_t zigzag(int32_t value);
+static int32_t unzigzag(uint32_t value);
+static int lowest_bit(uint64_t value);
 
 ga_snapshot::ga_snapshot()
 {
-	_ack = false;
+	_num_entities = 0;
 }
 
 ga_snapshot::ga_snapshot(int num_entities)
 {
-	_ack = false;
-	for (int i = 0; i < num_entities; i++)
-	{
-		_positions.push_back(ga_vec3f::zero_vector());
-	}
+	_num_entities = 0;
+	resize(num_entities);
 }
 
 ga_snapshot::~ga_snapshot()
@@ -23,30 +37,344 @@ ga_snapshot::~ga_snapshot()
 
 void ga_snapshot::add_entity(int e,const ga_entity& ent)
 {
-	_positions[e] = ent.get_transform().get_translation();
+	const ga_mat4f& transform = ent.get_transform();
+	ga_vec3f position = transform.get_translation();
+	for (int axis = 0; axis < 3; axis++)
+	{
+		_fields[k_field_x + axis][e] = ga_quantize_float(position.axes[axis],
+			_quantization._world_min.axes[axis],
+			_quantization._world_max.axes[axis],
+			_quantization._precision.axes[axis]);
+	}
+	_fields[k_field_rotation][e] = ga_quantize_quat(transform.get_rotation(), _quantization._rotation_bits);
+	_live[e >> 6] |= 1ull << (e & 63);
+}
+
+void ga_snapshot::remove_entity(int e)
+{
+	for (int f = 0; f < k_field_count; f++)
+	{
+		_fields[f][e] = 0;
+	}
+	_live[e >> 6] &= ~(1ull << (e & 63));
+}
+
+bool ga_snapshot::is_live(int e) const
+{
+	return e < _num_entities && (_live[e >> 6] >> (e & 63)) & 1;
+}
+
+uint64_t ga_snapshot::get_live_block(int block) const
+{
+	return _live[block];
+}
+
+void ga_snapshot::apply_entity(int e, ga_entity* ent) const
+{
+	ent->set_transform(get_transform(e));
+}
+
+ga_mat4f ga_snapshot::get_transform(int e) const
+{
+	ga_vec3f position;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		position.axes[axis] = ga_dequantize_float(_fields[k_field_x + axis][e],
+			_quantization._world_min.axes[axis],
+			_quantization._precision.axes[axis]);
+	}
+	ga_mat4f transform;
+	transform.make_rotation(ga_dequantize_quat(_fields[k_field_rotation][e], _quantization._rotation_bits));
+	transform.set_translation(position);
+	return transform;
+}
+
+int ga_snapshot::num_entities() const
+{
+	return _num_entities;
+}
+
+void ga_snapshot::resize(int num_entities)
+{
+	// Ids dropped off the end must read back as zeroes if grown again
+	for (int e = num_entities; e < _num_entities; e++)
+	{
+		remove_entity(e);
+	}
+	_num_entities = num_entities;
+	int padded = (num_entities + 63) & ~63;
+	for (int f = 0; f < k_field_count; f++)
+	{
+		_fields[f].resize(padded, 0);
+	}
+	_live.resize(padded / 64, 0);
+}
+
+int ga_snapshot::num_blocks() const
+{
+	return (int)_fields[0].size() / 64;
+}
+
+void ga_snapshot::set_quantization(const ga_quantization& quantization)
+{
+	_quantization = quantization;
+}
+
+const ga_quantization& ga_snapshot::get_quantization()
+{
+	return _quantization;
+}
+
+uint64_t ga_snapshot::compare_block(const ga_snapshot& source, const ga_snapshot& curr, int block)
+{
+	// Returns a bit per entity in [block * 64, block * 64 + 64) whose fields differ
+	const uint32_t* a[k_field_count];
+	const uint32_t* b[k_field_count];
+	for (int f = 0; f < k_field_count; f++)
+	{
+		a[f] = source._fields[f].data() + block * 64;
+		b[f] = curr._fields[f].data() + block * 64;
+	}
+	uint64_t dirty = source._live[block] ^ curr._live[block];
+#if defined(GA_AVX2)
+	for (int i = 0; i < 64; i += 8)
+	{
+		__m256i equal = _mm256_set1_epi32(-1);
+		for (int f = 0; f < k_field_count; f++)
+		{
+			__m256i x = _mm256_loadu_si256((const __m256i*)(a[f] + i));
+			__m256i y = _mm256_loadu_si256((const __m256i*)(b[f] + i));
+			equal = _mm256_and_si256(equal, _mm256_cmpeq_epi32(x, y));
+		}
+		uint64_t changed = ~_mm256_movemask_ps(_mm256_castsi256_ps(equal)) & 0xff;
+		dirty |= changed << i;
+	}
+#elif defined(GA_SSE2)
+	for (int i = 0; i < 64; i += 4)
+	{
+		__m128i equal = _mm_set1_epi32(-1);
+		for (int f = 0; f < k_field_count; f++)
+		{
+			__m128i x = _mm_loadu_si128((const __m128i*)(a[f] + i));
+			__m128i y = _mm_loadu_si128((const __m128i*)(b[f] + i));
+			equal = _mm_and_si128(equal, _mm_cmpeq_epi32(x, y));
+		}
+		uint64_t changed = ~_mm_movemask_ps(_mm_castsi128_ps(equal)) & 0xf;
+		dirty |= changed << i;
+	}
+#else
+	for (int i = 0; i < 64; i++)
+	{
+		for (int f = 0; f < k_field_count; f++)
+		{
+			if (a[f][i] != b[f][i])
+			{
+				dirty |= 1ull << i;
+				break;
+			}
+		}
+	}
+#endif
+	return dirty;
 }
 
-void ga_snapshot::ack()
+bool ga_snapshot::diff(const ga_snapshot& source, const ga_snapshot& curr, ga_bit_writer* writer,
+	const uint64_t* relevant, const uint64_t* entered, const uint64_t* left)
 {
-	_ack = true;
+	// Each changed entity is written as:
+	// [1 bit more][varint gap from previous index][4 bit field mask][fields]
+	// and the list is terminated by a zero "more" bit.
+	// Position axes that moved by less than _delta_bits are sent as a
+	// zigzagged delta from the baseline, otherwise as the full quantized value.
+	// A changed entity always has a field set, so an empty mask means the
+	// entity was removed, or that the receiver should stop holding it.
+	int axis_bits[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		axis_bits[axis] = _quantization.get_axis_bits(axis);
+	}
+	const uint32_t delta_limit = 1u << _quantization._delta_bits;
+	const int rotation_bits = 2 + 3 * _quantization._rotation_bits;
+
+	bool changed = false;
+	int last = -1;
+	int blocks = (int)source._fields[0].size() / 64;
+	for (int block = 0; block < blocks; block++)
+	{
+		// Dead entities have zeroed fields, so only differ by dying
+		uint64_t dirty = compare_block(source, curr, block);
+		uint64_t live = curr._live[block];
+		uint64_t removed = (dirty & ~live) | (left ? left[block] & live : 0);
+		uint64_t full = ((entered ? entered[block] : 0) | ~source._live[block]) & live & ~removed;
+		dirty &= live & ~removed;
+		if (relevant)
+		{
+			dirty &= relevant[block];
+			full &= relevant[block];
+		}
+		dirty |= full | removed;
+		while (dirty != 0)
+		{
+			int bit = lowest_bit(dirty);
+			int i = block * 64 + bit;
+			dirty &= dirty - 1;
+			bool absolute = (full >> bit) & 1;
+
+			bool removal = (removed >> bit) & 1;
+			uint32_t mask = absolute ? (1 << k_field_count) - 1 : 0;
+			for (int f = 0; f < k_field_count && !absolute && !removal; f++)
+			{
+				if (source._fields[f][i] != curr._fields[f][i])
+				{
+					mask |= 1 << f;
+				}
+			}
+			writer->write_bool(true);
+			writer->write_varint(i - last - 1);
+			writer->write_bits(mask, k_field_count);
+			for (int axis = 0; axis < 3; axis++)
+			{
+				if (mask & (1 << axis))
+				{
+					uint32_t from = source._fields[k_field_x + axis][i];
+					uint32_t to = curr._fields[k_field_x + axis][i];
+					uint32_t delta = zigzag((int32_t)(to - from));
+					bool small = !absolute && delta < delta_limit;
+					writer->write_bool(small);
+					if (small)
+					{
+						writer->write_bits(delta, _quantization._delta_bits);
+					}
+					else
+					{
+						writer->write_bits(to, axis_bits[axis]);
+					}
+				}
+			}
+			if (mask & (1 << k_field_rotation))
+			{
+				writer->write_bits(curr._fields[k_field_rotation][i], rotation_bits);
+			}
+			last = i;
+			changed = true;
+		}
+	}
+	writer->write_bool(false);
+	return changed;
 }
 
-char * ga_snapshot::diff(ga_snapshot source, ga_snapshot curr)
+bool ga_snapshot::patch(const ga_snapshot& source, ga_bit_reader* reader, ga_snapshot* curr)
 {
-	char buffer[MAX_BUFFER];
-	buffer[0] = '\0';
-	// Assume that source and curr have the same number of entities
-	for (int i = 0; i < source._positions.size(); i++)
+	int axis_bits[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		axis_bits[axis] = _quantization.get_axis_bits(axis);
+	}
+	const int rotation_bits = 2 + 3 * _quantization._rotation_bits;
+
+	// Rebuild curr from source plus the changes written by diff
+	*curr = source;
+	int index = -1;
+	while (reader->read_bool())
 	{
+		// Bound the gap before adding it so a hostile value cannot wrap index
+		uint32_t gap = reader->read_varint();
+		if (reader->overflowed() || gap >= (uint32_t)(MAX_NETWORK_ENTITIES - (index + 1)))
+		{
+			return false;
+		}
+		index += gap + 1;
+		uint32_t mask = reader->read_bits(k_field_count);
+		if (reader->overflowed())
+		{
+			return false;
+		}
+		if (index >= curr->_num_entities)
+		{
+			curr->resize(index + 1);
+		}
+		if (mask == 0)
+		{
+			curr->remove_entity(index);
+			continue;
+		}
+		curr->_live[index >> 6] |= 1ull << (index & 63);
 		for (int axis = 0; axis < 3; axis++)
 		{
-			if (source._positions[i].axes[axis] != curr._positions[i].axes[axis])
+			if (mask & (1 << axis))
 			{
-				char tmp[MAX_BUFFER];
-				sprintf(tmp, "Box %d %d %f ", i, axis, curr._positions[i].axes[axis]);
-				strcat(buffer, tmp);
+				uint32_t& to = curr->_fields[k_field_x + axis][index];
+				if (reader->read_bool())
+				{
+					to += unzigzag(reader->read_bits(_quantization._delta_bits));
+				}
+				else
+				{
+					to = reader->read_bits(axis_bits[axis]);
+				}
 			}
 		}
+		if (mask & (1 << k_field_rotation))
+		{
+			curr->_fields[k_field_rotation][index] = reader->read_bits(rotation_bits);
+		}
+	}
+	return !reader->overflowed();
+}
+
+int ga_snapshot::entity_bits(const ga_snapshot& source, const ga_snapshot& curr, int e, bool absolute)
+{
+	// Mirrors the layout written by diff
+	const uint32_t delta_limit = 1u << _quantization._delta_bits;
+	int bits = 1 + k_field_count;
+	if (!curr.is_live(e))
+	{
+		return bits;
+	}
+	absolute = absolute || !source.is_live(e);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		uint32_t from = source._fields[k_field_x + axis][e];
+		uint32_t to = curr._fields[k_field_x + axis][e];
+		if (!absolute && from == to)
+		{
+			continue;
+		}
+		bool small = !absolute && zigzag((int32_t)(to - from)) < delta_limit;
+		bits += 1 + (small ? _quantization._delta_bits : _quantization.get_axis_bits(axis));
+	}
+	if (absolute || source._fields[k_field_rotation][e] != curr._fields[k_field_rotation][e])
+	{
+		bits += 2 + 3 * _quantization._rotation_bits;
+	}
+	return bits;
+}
+
+static uint32_t zigzag(int32_t value)
+{
+	return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value)
+{
+	return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static int lowest_bit(uint64_t value)
+{
+#if defined(GA_MSVC) && defined(GA_64_BIT)
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return (int)index;
+#elif defined(GA_MSVC)
+	unsigned long index;
+	if (_BitScanForward(&index, (unsigned long)value))
+	{
+		return (int)index;
 	}
-	return buffer;
+	_BitScanForward(&index, (unsigned long)(value >> 32));
+	return (int)index + 32;
+#else
+	return __builtin_ctzll(value);
+#endif
 }
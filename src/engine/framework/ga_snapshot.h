@@ -1,7 +1,32 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include "../entity/ga_entity.h"
+#include "network/ga_quantize.h"
 
+#define MAX_SNAPSHOTS 32
+#define NO_BASELINE 0xff
+#define MAX_NETWORK_ENTITIES 0xffff
+
+/*
+** Snapshot fields, each stored as its own contiguous array.
+*/
+enum ga_snapshot_field
+{
+	k_field_x,
+	k_field_y,
+	k_field_z,
+	k_field_rotation,
+	k_field_count,
+};
+
+/*
+** Quantized entity state for one frame, laid out as structure-of-arrays so
+** that change detection can compare many entities per instruction.
+** Entities are indexed by network id. Only ids with their live bit set
+** exist in this frame; the fields of the rest are kept zeroed.
+** Arrays are padded to a multiple of 64 entities with zeroes.
+*/
 class ga_snapshot
 {
 public:
@@ -9,10 +34,44 @@ public:
 	ga_snapshot(int num_entities);
 	~ga_snapshot();
 	
+	// Captures ent as live under id e, or marks e as not existing.
 	void add_entity(int e, const ga_entity& ent);
-	void ack();
-	static char* diff(ga_snapshot source, ga_snapshot curr);
+	void remove_entity(int e);
+	bool is_live(int e) const;
+	uint64_t get_live_block(int block) const;
+
+	void apply_entity(int e, ga_entity* ent) const;
+	ga_mat4f get_transform(int e) const;
+
+	// Number of ids, live or not. Growing adds ids that are not live.
+	int num_entities() const;
+	void resize(int num_entities);
+
+	// A bit per entity in the block whose fields or liveness differ.
+	static uint64_t compare_block(const ga_snapshot& source, const ga_snapshot& curr, int block);
+	int num_blocks() const;
+
+	// Only entities set in relevant (one bit each, per block of 64) are
+	// written. Those set in entered are written in full even if unchanged,
+	// as the receiver's copy of them is not the source's. Entities that
+	// became live since source are written in full too, and those no longer
+	// live are always written, as removals. Those set in left are written as
+	// removals while still live, the receiver stops holding them.
+	// Source and curr must have the same number of entities; patch grows
+	// curr to fit whatever ids it reads.
+	static bool diff(const ga_snapshot& source, const ga_snapshot& curr, class ga_bit_writer* writer,
+		const uint64_t* relevant = NULL, const uint64_t* entered = NULL, const uint64_t* left = NULL);
+	static bool patch(const ga_snapshot& source, class ga_bit_reader* reader, ga_snapshot* curr);
+
+	// Bits diff spends on entity e, not counting the varint gap before it.
+	static int entity_bits(const ga_snapshot& source, const ga_snapshot& curr, int e, bool absolute);
+
+	static void set_quantization(const ga_quantization& quantization);
+	static const ga_quantization& get_quantization();
 private:
-	std::vector<ga_vec3f> _positions;
-	bool _ack;
-};
\ No newline at end of file
+	std::vector<uint32_t> _fields[k_field_count];
+	std::vector<uint64_t> _live;
+	int _num_entities;
+
+	static ga_quantization _quantization;
+};
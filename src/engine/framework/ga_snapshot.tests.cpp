@@ -0,0 +1,247 @@
+#include "ga_snapshot.tests.h"
+#include "ga_snapshot.h"
+
+#include "network/ga_bitstream.h"
+
+#include <cassert>
+
+void ga_snapshot_unit_tests()
+{
+	// Test a diff rebuilds the current snapshot on top of its baseline.
+	{
+		ga_entity a, b, c;
+		ga_quatf rotation;
+		rotation.make_axis_angle(ga_vec3f::x_vector(), ga_degrees_to_radians(90.0f));
+		a.rotate(rotation);
+		a.translate({ 1.0f, 2.0f, 3.0f });
+		b.translate({ -4.0f, 0.0f, 0.5f });
+		c.translate({ 0.0f, 0.0f, 0.0f });
+
+		ga_snapshot source(3);
+		source.add_entity(0, a);
+		source.add_entity(1, b);
+		source.add_entity(2, c);
+
+		b.translate({ 0.0f, 0.0f, 0.25f });
+		c.translate({ 200.0f, 0.0f, 0.0f });
+		ga_snapshot curr(3);
+		curr.add_entity(0, a);
+		curr.add_entity(1, b);
+		curr.add_entity(2, c);
+
+		unsigned char buffer[64];
+		ga_bit_writer writer(buffer, sizeof(buffer));
+		assert(ga_snapshot::diff(source, curr, &writer));
+		assert(!writer.overflowed());
+
+		ga_snapshot result;
+		ga_bit_reader reader(buffer, writer.get_bytes_written());
+		assert(ga_snapshot::patch(source, &reader, &result));
+
+		ga_entity check;
+		result.apply_entity(1, &check);
+		assert(check.get_transform().get_translation().equal({ -4.0f, 0.0f, 0.75f }));
+		result.apply_entity(2, &check);
+		assert(check.get_transform().get_translation().equal({ 200.0f, 0.0f, 0.0f }));
+		result.apply_entity(0, &check);
+		assert(check.get_transform().get_translation().equal({ 1.0f, 2.0f, 3.0f }));
+		ga_vec3f up = check.get_transform().transform_vector(ga_vec3f::y_vector());
+		assert(ga_absf(up.z - a.get_transform().transform_vector(ga_vec3f::y_vector()).z) < 0.001f);
+	}
+
+	// Test change detection flags exactly the changed entities across blocks.
+	{
+		ga_entity moved;
+		moved.translate({ 0.0f, 1.0f, 0.0f });
+		ga_snapshot source(130);
+		ga_snapshot curr(130);
+		curr.add_entity(0, moved);
+		curr.add_entity(63, moved);
+		curr.add_entity(64, moved);
+		curr.add_entity(129, moved);
+		assert(ga_snapshot::compare_block(source, curr, 0) == ((1ull << 63) | 1ull));
+		assert(ga_snapshot::compare_block(source, curr, 1) == 1ull);
+		assert(ga_snapshot::compare_block(source, curr, 2) == (1ull << 1));
+
+		unsigned char buffer[128];
+		ga_bit_writer writer(buffer, sizeof(buffer));
+		assert(ga_snapshot::diff(source, curr, &writer));
+		ga_snapshot result;
+		ga_bit_reader reader(buffer, writer.get_bytes_written());
+		assert(ga_snapshot::patch(source, &reader, &result));
+		assert(ga_snapshot::compare_block(result, curr, 0) == 0);
+		assert(ga_snapshot::compare_block(result, curr, 1) == 0);
+		assert(ga_snapshot::compare_block(result, curr, 2) == 0);
+	}
+
+	// Test identical snapshots produce an empty diff.
+	{
+		ga_snapshot source(2);
+		unsigned char buffer[8];
+		ga_bit_writer writer(buffer, sizeof(buffer));
+		assert(!ga_snapshot::diff(source, source, &writer));
+		assert(writer.get_bits_written() == 1);
+	}
+
+	// Test a gap that would wrap the entity index is rejected.
+	{
+		ga_snapshot source(2);
+		unsigned char buffer[16];
+		ga_bit_writer writer(buffer, sizeof(buffer));
+		writer.write_bool(true);
+		writer.write_varint(0);
+		writer.write_bits(0, k_field_count);
+		writer.write_bool(true);
+		writer.write_varint(0xfffffffe);
+		writer.write_bits(0, k_field_count);
+		writer.write_bool(false);
+
+		ga_snapshot result;
+		ga_bit_reader reader(buffer, writer.get_bytes_written());
+		assert(!ga_snapshot::patch(source, &reader, &result));
+
+		ga_bit_writer past_end(buffer, sizeof(buffer));
+		past_end.write_bool(true);
+		past_end.write_varint(MAX_NETWORK_ENTITIES);
+		past_end.write_bits(1, k_field_count);
+		past_end.write_bool(false);
+		ga_bit_reader past_end_reader(buffer, past_end.get_bytes_written());
+		assert(!ga_snapshot::patch(source, &past_end_reader, &result));
+	}
+
+	// Test irrelevant entities are skipped and entered ones are sent in full.
+	{
+		ga_entity near, far, returning;
+		ga_snapshot source(3);
+		near.translate({ 1.0f, 0.0f, 0.0f });
+		far.translate({ 2.0f, 0.0f, 0.0f });
+		returning.translate({ 3.0f, 0.0f, 0.0f });
+		ga_snapshot curr(3);
+		curr.add_entity(0, near);
+		curr.add_entity(1, far);
+		curr.add_entity(2, returning);
+
+		// The receiver's baseline holds an old value for the returning entity.
+		ga_snapshot stale(3);
+		returning.translate({ -50.0f, 0.0f, 0.0f });
+		stale.add_entity(2, returning);
+		returning.translate({ 50.0f, 0.0f, 0.0f });
+
+		uint64_t relevant = (1ull << 0) | (1ull << 2);
+		uint64_t entered = 1ull << 2;
+		unsigned char buffer[64];
+		ga_bit_writer writer(buffer, sizeof(buffer));
+		assert(ga_snapshot::diff(source, curr, &writer, &relevant, &entered));
+
+		ga_snapshot result;
+		ga_bit_reader reader(buffer, writer.get_bytes_written());
+		assert(ga_snapshot::patch(stale, &reader, &result));
+		assert(result.get_transform(0).get_translation().equal({ 1.0f, 0.0f, 0.0f }));
+		assert(result.get_transform(1).get_translation().equal(stale.get_transform(1).get_translation()));
+		assert(result.get_transform(2).get_translation().equal({ 3.0f, 0.0f, 0.0f }));
+	}
+
+	// Test entities that left the receiver's view are written as removals.
+	{
+		ga_entity stays, leaves;
+		stays.translate({ 1.0f, 0.0f, 0.0f });
+		leaves.translate({ 2.0f, 0.0f, 0.0f });
+		ga_snapshot source(2);
+		source.add_entity(0, stays);
+		source.add_entity(1, leaves);
+		leaves.translate({ 50.0f, 0.0f, 0.0f });
+		ga_snapshot curr(2);
+		curr.add_entity(0, stays);
+		curr.add_entity(1, leaves);
+
+		uint64_t relevant = 1ull << 0;
+		uint64_t left = 1ull << 1;
+		unsigned char buffer[16];
+		ga_bit_writer writer(buffer, sizeof(buffer));
+		assert(ga_snapshot::diff(source, curr, &writer, &relevant, NULL, &left));
+		assert(writer.get_bits_written() == 1 + 8 + 1 + k_field_count);
+
+		ga_snapshot result;
+		ga_bit_reader reader(buffer, writer.get_bytes_written());
+		assert(ga_snapshot::patch(source, &reader, &result));
+		assert(result.is_live(0) && !result.is_live(1));
+	}
+
+	// Test per entity size estimates add up to what diff writes.
+	{
+		ga_entity small, large, turned, entered;
+		ga_snapshot source(4);
+		source.add_entity(0, small);
+		source.add_entity(1, large);
+		source.add_entity(2, turned);
+		small.translate({ 0.01f, 0.0f, 0.0f });
+		large.translate({ 100.0f, 0.0f, -20.0f });
+		ga_quatf rotation;
+		rotation.make_axis_angle(ga_vec3f::y_vector(), ga_degrees_to_radians(45.0f));
+		turned.rotate(rotation);
+		ga_snapshot curr(4);
+		curr.add_entity(0, small);
+		curr.add_entity(1, large);
+		curr.add_entity(2, turned);
+		curr.add_entity(3, entered);
+
+		uint64_t entered_mask = 1ull << 3;
+		unsigned char buffer[64];
+		ga_bit_writer writer(buffer, sizeof(buffer));
+		assert(ga_snapshot::diff(source, curr, &writer, NULL, &entered_mask));
+
+		// Each entity also pays one byte for its index gap, the list one
+		// terminating bit
+		int bits = 1;
+		for (int e = 0; e < 4; e++)
+		{
+			bits += 8 + ga_snapshot::entity_bits(source, curr, e, e == 3);
+		}
+		assert(writer.get_bits_written() == bits);
+	}
+
+	// Test spawns, removals, and ids past the end of the receiver's copy.
+	{
+		ga_entity kept, removed, spawned;
+		kept.translate({ 1.0f, 0.0f, 0.0f });
+		removed.translate({ 2.0f, 0.0f, 0.0f });
+		spawned.translate({ 3.0f, 0.0f, 0.0f });
+		ga_snapshot source(128);
+		source.add_entity(0, kept);
+		source.add_entity(1, removed);
+		ga_snapshot curr(128);
+		curr.add_entity(0, kept);
+		curr.add_entity(100, spawned);
+		assert(ga_snapshot::compare_block(source, curr, 0) == (1ull << 1));
+		assert(ga_snapshot::compare_block(source, curr, 1) == (1ull << 36));
+
+		// Removals go out even when not relevant, spawns only when relevant
+		uint64_t relevant[2] = { 1ull << 0, 1ull << 36 };
+		unsigned char buffer[64];
+		ga_bit_writer writer(buffer, sizeof(buffer));
+		assert(ga_snapshot::diff(source, curr, &writer, relevant));
+		int bits = 1 + 8 + ga_snapshot::entity_bits(source, curr, 1, false) +
+			8 + ga_snapshot::entity_bits(source, curr, 100, false);
+		assert(writer.get_bits_written() == bits);
+
+		ga_snapshot receiver(2);
+		receiver.add_entity(0, kept);
+		receiver.add_entity(1, removed);
+		ga_snapshot result;
+		ga_bit_reader reader(buffer, writer.get_bytes_written());
+		assert(ga_snapshot::patch(receiver, &reader, &result));
+		assert(result.num_entities() == 101);
+		assert(result.is_live(0) && !result.is_live(1) && result.is_live(100));
+		assert(!result.is_live(50) && !result.is_live(200));
+		assert(result.get_transform(100).get_translation().equal({ 3.0f, 0.0f, 0.0f }));
+
+		// A removed id compares equal to one never used
+		ga_snapshot empty(128);
+		empty.add_entity(0, kept);
+		empty.add_entity(100, spawned);
+		result.resize(128);
+		assert(ga_snapshot::compare_block(result, empty, 0) == 0);
+		assert(ga_snapshot::compare_block(result, empty, 1) == 0);
+		assert(ga_snapshot::compare_block(curr, empty, 0) == 0);
+	}
+}
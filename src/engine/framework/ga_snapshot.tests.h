@@ -0,0 +1,3 @@
+#pragma once
+
+void ga_snapshot_unit_tests();
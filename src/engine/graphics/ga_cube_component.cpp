@@ -180,7 +180,10 @@ void ga_cube_component::update(ga_frame_params* params)
 	ga_quatf axis_angle;
 	axis_angle.make_axis_angle(ga_vec3f::y_vector(), ga_degrees_to_radians(60.0f) * dt);
 	get_entity()->rotate(axis_angle);
+}
 
+void ga_cube_component::draw(ga_frame_params* params)
+{
 	ga_static_drawcall draw;
 	draw._name = "ga_cube_component";
 	draw._vao = _vao;
@@ -23,6 +23,7 @@ public:
 	virtual ~ga_cube_component();
 
 	virtual void update(struct ga_frame_params* params) override;
+	virtual void draw(struct ga_frame_params* params) override;
 
 private:
 	class ga_material* _material;
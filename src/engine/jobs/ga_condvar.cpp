@@ -29,7 +29,23 @@ void ga_condvar::wait_for(int ms)
 	_condvar.wait_for(lock, std::chrono::milliseconds(ms));
 }
 
+void ga_condvar::wait_for(int ms, uint32_t wake_count)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_condvar.wait_for(lock, std::chrono::milliseconds(ms), [&]() { return _wake_count != wake_count; });
+}
+
 void ga_condvar::wake_all()
 {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		++_wake_count;
+	}
 	_condvar.notify_all();
 }
+
+uint32_t ga_condvar::get_wake_count()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _wake_count;
+}
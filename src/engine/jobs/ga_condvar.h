@@ -10,10 +10,13 @@
 */
 
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
 
 /*
 ** Condition variable object.
+** Waiters that check their condition outside the lock can read the wake
+** count first and wait on it, so a wake in between is never lost.
 */
 class ga_condvar
 {
@@ -23,9 +26,13 @@ public:
 
 	void wait();
 	void wait_for(int ms);
+	void wait_for(int ms, uint32_t wake_count);
 	void wake_all();
 
+	uint32_t get_wake_count();
+
 private:
 	std::condition_variable _condvar;
 	std::mutex _mutex;
+	uint32_t _wake_count = 0;
 };
@@ -9,6 +9,7 @@
 
 #include "ga_fiber.h"
 
+#if defined(GA_MSVC) || defined(GA_MINGW)
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #undef WIN32_LEAN_AND_MEAN
@@ -56,3 +57,95 @@ void* ga_fiber::get_data()
 {
 	return GetFiberData();
 }
+
+#else
+
+#include <cstdlib>
+#include <ucontext.h>
+
+/*
+** Fibers are ucontexts off Windows. Each thread tracks the fiber it is
+** running, which is how a new fiber finds its function and data.
+*/
+struct ga_fiber_impl_t
+{
+	ucontext_t _context;
+	ga_fiber::function_t _func;
+	void* _data;
+	void* _stack;
+};
+
+static thread_local ga_fiber_impl_t* t_current_fiber = 0;
+
+static void _ga_fiber_entry()
+{
+	ga_fiber_impl_t* impl = t_current_fiber;
+	impl->_func(impl->_data);
+}
+
+ga_fiber::ga_fiber(function_t func, void* func_data, size_t stack_size)
+{
+	const size_t k_stack_align = 64 * 1024;
+	stack_size = stack_size > k_stack_align ? stack_size : k_stack_align;
+	stack_size = (stack_size + k_stack_align - 1) & ~(k_stack_align - 1);
+
+	ga_fiber_impl_t* impl = new ga_fiber_impl_t();
+	impl->_func = func;
+	impl->_data = func_data;
+	impl->_stack = malloc(stack_size);
+	getcontext(&impl->_context);
+	impl->_context.uc_stack.ss_sp = impl->_stack;
+	impl->_context.uc_stack.ss_size = stack_size;
+	impl->_context.uc_link = 0;
+	makecontext(&impl->_context, _ga_fiber_entry, 0);
+	_impl = impl;
+}
+
+ga_fiber::~ga_fiber()
+{
+	ga_fiber_impl_t* impl = static_cast<ga_fiber_impl_t*>(_impl);
+	if (impl)
+	{
+		free(impl->_stack);
+		delete impl;
+	}
+}
+
+ga_fiber& ga_fiber::operator=(ga_fiber&& other)
+{
+	if (&other != this)
+	{
+		_impl = other._impl;
+		other._impl = 0;
+	}
+	return *this;
+}
+
+ga_fiber ga_fiber::convert_thread(void* data)
+{
+	// The thread's own stack; its context is filled in when it switches away
+	ga_fiber_impl_t* impl = new ga_fiber_impl_t();
+	impl->_func = 0;
+	impl->_data = data;
+	impl->_stack = 0;
+	t_current_fiber = impl;
+
+	ga_fiber fiber;
+	fiber._impl = impl;
+	return fiber;
+}
+
+void ga_fiber::switch_to(const ga_fiber& fiber)
+{
+	ga_fiber_impl_t* from = t_current_fiber;
+	ga_fiber_impl_t* to = static_cast<ga_fiber_impl_t*>(fiber._impl);
+	t_current_fiber = to;
+	swapcontext(&from->_context, &to->_context);
+}
+
+void* ga_fiber::get_data()
+{
+	return t_current_fiber->_data;
+}
+
+#endif
@@ -15,6 +15,8 @@
 #include <sys/types.h>
 #endif
 
+#include <cstddef>
+
 /*
 ** A fiber object.
 ** This the execution context for a thread including the registers and stack.
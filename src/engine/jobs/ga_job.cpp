@@ -118,9 +118,13 @@ void ga_job::run(ga_job_decl_t* decls, int decl_count, int32_t* counter)
 	{
 		decls[i]._pending_count = counter;
 		impl->_job_queue.push(decls + i);
-	}
 
-	impl->_work_added.wake_all();
+		/*
+		** Wake workers as each job goes in. A batch larger than the queue
+		** blocks in push until they drain it.
+		*/
+		impl->_work_added.wake_all();
+	}
 }
 
 void ga_job::wait(int32_t* counter)
@@ -142,12 +146,19 @@ void ga_job::wait(int32_t* counter)
 		}
 		/*
 		** Otherwise, in the main thread, block until jobs are complete.
+		** The last job can finish between checking the counter and waiting,
+		** so wait on the wake count read before the check.
 		*/
 		else
 		{
-			while (*counter > 0)
+			while (true)
 			{
-				impl->_work_exhausted.wait();
+				uint32_t wake_count = impl->_work_exhausted.get_wake_count();
+				if (*counter <= 0)
+				{
+					break;
+				}
+				impl->_work_exhausted.wait_for(1000, wake_count);
 			}
 		}
 	}
@@ -161,10 +172,11 @@ static int _ga_job_instance_thread_worker(void* data)
 
 	while (!impl->_terminate)
 	{
+		uint32_t wake_count = impl->_work_added.get_wake_count();
 		if (!_ga_job_schedule(impl, &parent_fiber))
 		{
 			impl->_work_exhausted.wake_all();
-			impl->_work_added.wait_for(1000);
+			impl->_work_added.wait_for(1000, wake_count);
 		}
 	}
 
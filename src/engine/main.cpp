@@ -9,15 +9,19 @@
 
 #include "framework/ga_camera.h"
 #include "framework/ga_compiler_defines.h"
-#include "framework/ga_input.h"
 #include "framework/ga_sim.h"
-#include "framework/ga_output.h"
+#include "framework/ga_snapshot.tests.h"
 #include "jobs/ga_job.h"
 
 #include "entity/ga_entity.h"
 
+#if !defined(GA_HEADLESS_ONLY)
+#include "framework/ga_input.h"
+#include "framework/ga_output.h"
+
 #include "graphics/ga_cube_component.h"
 #include "graphics/ga_program.h"
+#endif
 
 #include "physics/ga_intersection.tests.h"
 #include "physics/ga_physics_component.h"
@@ -28,31 +32,105 @@
 #include "network/ga_udp_server.h"
 #include "network/ga_udp_client.h"
 #include "network/ga_address.h"
-
+#include "network/ga_bitstream.tests.h"
+#include "network/ga_client_table.tests.h"
+#include "network/ga_fragment.tests.h"
+#include "network/ga_input_command.tests.h"
+#include "network/ga_interpolation_buffer.tests.h"
+#include "network/ga_loopback.tests.h"
+#include "network/ga_network_stats.tests.h"
+#include "network/ga_packet_header.tests.h"
+#include "network/ga_packet_pool.tests.h"
+#include "network/ga_quantize.tests.h"
+#include "network/ga_reliable_channel.tests.h"
+#include "network/ga_send_rate.tests.h"
+#include "network/ga_spatial_grid.tests.h"
+
+#if !defined(GA_HEADLESS_ONLY)
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 #define STB_TRUETYPE_IMPLEMENTATION
 #include <stb_truetype.h>
+#endif
 
 #if defined(GA_MINGW)
 #include <unistd.h>
 #endif
 
+#include <csignal>
+#include <cstring>
 #include <fstream>
 static void set_root_path(const char* exepath);
 static void run_unit_tests();
+static void run_headless_server(ga_udp_server* server, ga_sim* sim, ga_physics_world* world);
+#if !defined(GA_HEADLESS_ONLY)
+static void make_tick_params(const ga_frame_params& frame, bool first_tick, ga_frame_params* tick);
+#endif
+
+// Rate simulation, physics and networking tick at, independent of the render rate.
+static const int k_sim_tick_rate = 60;
+
+// Most ticks run to catch up in one frame; any further backlog is dropped.
+static const int k_max_ticks_per_frame = 4;
+
+static const std::chrono::high_resolution_clock::duration k_tick_interval =
+	std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+		std::chrono::microseconds(1000000 / k_sim_tick_rate));
+
+/*
+** Hands each connecting client one of the boxes to control, lowest id first,
+** and puts it back when the client leaves. Clients past the last box
+** control nothing.
+*/
+class ga_box_assigner : public ga_player_factory
+{
+public:
+	ga_box_assigner(int count) : _taken(count, false) {}
+
+	uint16_t spawn(int) override
+	{
+		for (size_t id = 0; id < _taken.size(); id++)
+		{
+			if (!_taken[id])
+			{
+				_taken[id] = true;
+				return (uint16_t)id;
+			}
+		}
+		return NO_PLAYER_ENTITY;
+	}
+
+	void despawn(int, uint16_t id) override
+	{
+		_taken[id] = false;
+	}
+
+private:
+	std::vector<bool> _taken;
+};
 
 int main(int argc, const char** argv)
 {
 	// Parse command line arguments
-	if (argc != 3)
+	if (argc != 3 && argc != 4)
 	{
 		printf("Invalid number of arguments\n");
 		exit(1);
 	}
 	bool is_server = strcmp(argv[1],"server") == 0;
 	short port = atoi(argv[2]);
+#if defined(GA_HEADLESS_ONLY)
+	// Built without a window or renderer, so only the headless server runs
+	bool is_headless = true;
+#else
+	bool is_headless = argc == 4 && strcmp(argv[3], "headless") == 0;
+#endif
+	if (is_headless && !is_server)
+	{
+		printf("Only the server can run headless\n");
+		exit(1);
+	}
 	set_root_path(argv[0]);
 
 	ga_job::startup(0xffff, 256, 256);
@@ -60,10 +138,13 @@ int main(int argc, const char** argv)
 	run_unit_tests();
 
 	// Create objects for three phases of the frame: input, sim and output.
-	ga_input* input = new ga_input();
+	// A headless server has no window or GL context, so skips input and output.
 	ga_sim* sim = new ga_sim();
 	ga_physics_world* world = new ga_physics_world();
-	ga_output* output = new ga_output(input->get_window());
+#if !defined(GA_HEADLESS_ONLY)
+	ga_input* input = is_headless ? NULL : new ga_input();
+	ga_output* output = is_headless ? NULL : new ga_output(input->get_window());
+#endif
 
 	// Create camera.
 	ga_camera* camera = new ga_camera({ 0.0f, 7.0f, 20.0f });
@@ -125,53 +206,114 @@ int main(int argc, const char** argv)
 	sim->add_entity(&floor);
 
 	// Create networking objects
-	ga_udp_server* server;
-	ga_udp_client* client;
+	// The boxes are the first four entities, so their network ids are 0-3
+	ga_box_assigner box_assigner(4);
+	ga_udp_server* server = NULL;
+	ga_udp_client* client = NULL;
 	if (is_server)
 	{
 		server = new ga_udp_server(port, sim);
+		server->set_player_factory(&box_assigner);
 	}
 	else {
 		client = new ga_udp_client(port, ga_address(127, 0, 0, 1, 9000), sim);
+		client->set_tick_rate(k_sim_tick_rate);
 	}
 
 	// Main loop:
-	while (true)
+	if (is_headless)
 	{
-		// We pass frame state through the 3 phases using a params object.
-		ga_frame_params params;
-
-		// Gather user input and current time.
-		if (!input->update(&params))
-		{
-			break;
-		}
-
-		// Communicate on network
-		if (!is_server) // Client sends commands to server
-		{
-			client->update(&params);
-		}
-		if (is_server)
+		run_headless_server(server, sim, world);
+	}
+#if !defined(GA_HEADLESS_ONLY)
+	else
+	{
+		std::chrono::high_resolution_clock::duration accumulator = std::chrono::high_resolution_clock::duration::zero();
+		std::vector<ga_dynamic_drawcall> tick_debug_drawcalls;
+		while (true)
 		{
-			server->update(&params);
+			// We pass frame state through the 3 phases using a params object.
+			ga_frame_params params;
+
+			// Gather user input and current time.
+			if (!input->update(&params))
+			{
+				break;
+			}
+
+			// Work out how many fixed ticks this frame owes. A single step while
+			// paused always runs exactly one.
+			int ticks = 1;
+			if (!params._single_step)
+			{
+				accumulator += params._delta_time;
+				ticks = int(accumulator / k_tick_interval);
+				accumulator -= k_tick_interval * ticks;
+				if (ticks > k_max_ticks_per_frame)
+				{
+					ticks = k_max_ticks_per_frame;
+				}
+			}
+
+			// Networking is pumped at least once every frame, including frames
+			// that owe no ticks such as while paused, so peers keep acking and
+			// don't time out. Only the simulation waits on the accumulator.
+			int steps = ticks > 0 ? ticks : 1;
+			for (int i = 0; i < steps; ++i)
+			{
+				bool step_sim = i < ticks;
+				ga_frame_params tick_params;
+				make_tick_params(params, i == 0, &tick_params);
+
+				if (step_sim)
+				{
+					sim->save_tick_state();
+				}
+
+				// Communicate on network
+				if (!is_server) // Client sends commands to server
+				{
+					client->update(&tick_params);
+				}
+				if (is_server)
+				{
+					server->update(&tick_params);
+				}
+
+				if (!step_sim)
+				{
+					continue;
+				}
+
+				// Run gameplay.
+				sim->update(&tick_params);
+
+				// Step the physics world. Only its collision draws are kept; the
+				// entities are drawn by the render pass below.
+				tick_params._dynamic_drawcalls.clear();
+				world->step(&tick_params);
+				tick_debug_drawcalls.swap(tick_params._dynamic_drawcalls);
+
+				// Perform the late update.
+				sim->late_update(&tick_params);
+			}
+
+			// Update the camera.
+			camera->update(&params);
+
+			// Render pass: emit drawcalls with every entity blended between its
+			// last two tick states. Only draws, so the simulation is untouched.
+			float alpha = std::chrono::duration<float>(accumulator) / std::chrono::duration<float>(k_tick_interval);
+			sim->begin_interpolation(alpha);
+			sim->draw(&params);
+			params._dynamic_drawcalls.insert(params._dynamic_drawcalls.end(), tick_debug_drawcalls.begin(), tick_debug_drawcalls.end());
+
+			// Draw to screen.
+			output->update(&params);
+			sim->end_interpolation();
 		}
-
-		// Update the camera.
-		camera->update(&params);
-
-		// Run gameplay.
-		sim->update(&params);
-
-		// Step the physics world.
-		world->step(&params);
-
-		// Perform the late update.
-		sim->late_update(&params);
-
-		// Draw to screen.
-		output->update(&params);
 	}
+#endif
 
 	world->remove_rigid_body(floor_collider.get_rigid_body());
 	world->remove_rigid_body(test_1_collider.get_rigid_body());
@@ -179,10 +321,15 @@ int main(int argc, const char** argv)
 	world->remove_rigid_body(test_3_collider.get_rigid_body());
 	world->remove_rigid_body(test_4_collider.get_rigid_body());
 
+	delete server;
+	delete client;
+
+#if !defined(GA_HEADLESS_ONLY)
 	delete output;
+	delete input;
+#endif
 	delete world;
 	delete sim;
-	delete input;
 	delete camera;
 
 	ga_job::shutdown();
@@ -217,8 +364,75 @@ static void set_root_path(const char* exepath)
 #endif
 }
 
-void run_unit_tests()
+static volatile sig_atomic_t g_quit = 0;
+static void handle_quit_signal(int)
+{
+	g_quit = 1;
+}
+
+static void run_headless_server(ga_udp_server* server, ga_sim* sim, ga_physics_world* world)
+{
+	// No render loop to pace us, so sleep on the server's tick clock instead.
+	std::signal(SIGINT, handle_quit_signal);
+	std::signal(SIGTERM, handle_quit_signal);
+
+	server->set_tick_rate(k_sim_tick_rate);
+	while (!g_quit)
+	{
+		if (!server->wait_for_tick(-1))
+		{
+			continue;
+		}
+
+		ga_frame_params params;
+		params._current_time = std::chrono::high_resolution_clock::now();
+		params._delta_time = k_tick_interval;
+		params._button_mask = 0;
+		params._mouse_click_mask = 0;
+		params._mouse_press_mask = 0;
+		params._mouse_x = 0.0f;
+		params._mouse_y = 0.0f;
+
+		server->update(&params);
+		sim->update(&params);
+		world->step(&params);
+		sim->late_update(&params);
+	}
+}
+
+#if !defined(GA_HEADLESS_ONLY)
+static void make_tick_params(const ga_frame_params& frame, bool first_tick, ga_frame_params* tick)
+{
+	tick->_current_time = frame._current_time;
+	tick->_delta_time = k_tick_interval;
+	tick->_button_mask = frame._button_mask;
+
+	// Clicks and presses are edges, so only the first tick of a frame sees them.
+	tick->_mouse_click_mask = first_tick ? frame._mouse_click_mask : 0;
+	tick->_mouse_press_mask = first_tick ? frame._mouse_press_mask : 0;
+	tick->_mouse_x = frame._mouse_x;
+	tick->_mouse_y = frame._mouse_y;
+
+	tick->_single_step = frame._single_step;
+}
+#endif
+
+static void run_unit_tests()
 {
 	ga_intersection_utility_unit_tests();
 	ga_intersection_unit_tests();
+	ga_bitstream_unit_tests();
+	ga_quantize_unit_tests();
+	ga_snapshot_unit_tests();
+	ga_fragment_unit_tests();
+	ga_packet_pool_unit_tests();
+	ga_packet_header_unit_tests();
+	ga_interpolation_buffer_unit_tests();
+	ga_input_command_unit_tests();
+	ga_client_table_unit_tests();
+	ga_spatial_grid_unit_tests();
+	ga_loopback_unit_tests();
+	ga_network_stats_unit_tests();
+	ga_send_rate_unit_tests();
+	ga_reliable_channel_unit_tests();
 }
@@ -326,6 +326,51 @@ void ga_mat4f::set_translation(const ga_vec3f& translation)
 	data[3][2] = translation.z;
 }
 
+ga_quatf ga_mat4f::get_rotation() const
+{
+	// Matrix is stored data[column][row]
+	float m00 = data[0][0], m01 = data[1][0], m02 = data[2][0];
+	float m10 = data[0][1], m11 = data[1][1], m12 = data[2][1];
+	float m20 = data[0][2], m21 = data[1][2], m22 = data[2][2];
+
+	ga_quatf q;
+	float trace = m00 + m11 + m22;
+	if (trace > 0.0f)
+	{
+		float s = 0.5f / ga_sqrtf(trace + 1.0f);
+		q.w = 0.25f / s;
+		q.x = (m21 - m12) * s;
+		q.y = (m02 - m20) * s;
+		q.z = (m10 - m01) * s;
+	}
+	else if (m00 > m11 && m00 > m22)
+	{
+		float s = 2.0f * ga_sqrtf(1.0f + m00 - m11 - m22);
+		q.w = (m21 - m12) / s;
+		q.x = 0.25f * s;
+		q.y = (m01 + m10) / s;
+		q.z = (m02 + m20) / s;
+	}
+	else if (m11 > m22)
+	{
+		float s = 2.0f * ga_sqrtf(1.0f + m11 - m00 - m22);
+		q.w = (m02 - m20) / s;
+		q.x = (m01 + m10) / s;
+		q.y = 0.25f * s;
+		q.z = (m12 + m21) / s;
+	}
+	else
+	{
+		float s = 2.0f * ga_sqrtf(1.0f + m22 - m00 - m11);
+		q.w = (m10 - m01) / s;
+		q.x = (m02 + m20) / s;
+		q.y = (m12 + m21) / s;
+		q.z = 0.25f * s;
+	}
+	q.normalize();
+	return q;
+}
+
 ga_vec3f ga_mat4f::get_forward() const
 {
 	return{ data[2][0], data[2][1], data[2][2] };
@@ -132,6 +132,13 @@ struct ga_mat4f
 	*/
 	void set_translation(const ga_vec3f& translation);
 
+	/*
+	** Get the rotation portion of the matrix as a quaternion.
+	**
+	** Assumes the upper 3x3 is orthonormal (no scale).
+	*/
+	ga_quatf get_rotation() const;
+
 	/*
 	** Get the forward vector from the matrix.
 	**
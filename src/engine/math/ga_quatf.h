@@ -121,3 +121,21 @@ struct ga_quatf
 		v4.normalize();
 	}
 };
+
+/*
+** Normalized linear interpolation between two rotations.
+** Takes the shorter arc, and is close enough to slerp for the small angles
+** covered between two simulation ticks.
+** @param t Blend factor, 0 returns a and 1 returns b.
+*/
+inline ga_quatf ga_quatf_nlerp(const ga_quatf& __restrict a, const ga_quatf& __restrict b, float t)
+{
+	float sign = a.v4.dot(b.v4) < 0.0f ? -1.0f : 1.0f;
+	ga_quatf result;
+	for (int i = 0; i < 4; ++i)
+	{
+		result.axes[i] = a.axes[i] + (b.axes[i] * sign - a.axes[i]) * t;
+	}
+	result.normalize();
+	return result;
+}
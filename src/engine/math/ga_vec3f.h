@@ -44,3 +44,16 @@ inline ga_vec3f ga_vec3f_cross(const ga_vec3f& __restrict a, const ga_vec3f& __r
 	result.z = (a.x * b.y) - (a.y * b.x);
 	return result;
 }
+
+/*
+** Linearly interpolate between two vectors.
+** @param t Blend factor, 0 returns a and 1 returns b.
+*/
+inline ga_vec3f ga_vec3f_lerp(const ga_vec3f& __restrict a, const ga_vec3f& __restrict b, float t)
+{
+	ga_vec3f result;
+	result.x = a.x + (b.x - a.x) * t;
+	result.y = a.y + (b.y - a.y) * t;
+	result.z = a.z + (b.z - a.z) * t;
+	return result;
+}
@@ -0,0 +1,147 @@
+#include "ga_bitstream.h"
+#include <cstring>
+
+ga_bit_writer::ga_bit_writer(void* buffer, int size)
+{
+	_buffer = (uint8_t*)buffer;
+	_size_bits = size * 8;
+	_bit_index = 0;
+	_overflow = false;
+}
+
+void ga_bit_writer::write_bits(uint32_t value, int bits)
+{
+	if (_overflow || _bit_index + bits > _size_bits)
+	{
+		_overflow = true;
+		return;
+	}
+	// Fill the current partial byte first, then whole bytes, lowest bits first
+	while (bits > 0)
+	{
+		int byte = _bit_index >> 3;
+		int offset = _bit_index & 7;
+		int count = 8 - offset < bits ? 8 - offset : bits;
+		uint8_t mask = (uint8_t)((1u << count) - 1);
+		if (offset == 0)
+		{
+			_buffer[byte] = 0;
+		}
+		_buffer[byte] |= (uint8_t)((value & mask) << offset);
+		value >>= count;
+		bits -= count;
+		_bit_index += count;
+	}
+}
+
+void ga_bit_writer::write_bool(bool value)
+{
+	write_bits(value ? 1 : 0, 1);
+}
+
+void ga_bit_writer::write_varint(uint32_t value)
+{
+	// 7 bits per group with a continuation bit, so small values stay small
+	while (value >= 0x80)
+	{
+		write_bits((value & 0x7f) | 0x80, 8);
+		value >>= 7;
+	}
+	write_bits(value, 8);
+}
+
+void ga_bit_writer::write_float(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	write_bits(bits, 32);
+}
+
+int ga_bit_writer::get_bits_written() const
+{
+	return _bit_index;
+}
+
+int ga_bit_writer::get_bytes_written() const
+{
+	return (_bit_index + 7) >> 3;
+}
+
+bool ga_bit_writer::overflowed() const
+{
+	return _overflow;
+}
+
+ga_bit_reader::ga_bit_reader(const void* buffer, int size)
+{
+	_buffer = (const uint8_t*)buffer;
+	_size_bits = size * 8;
+	_bit_index = 0;
+	_overflow = false;
+}
+
+uint32_t ga_bit_reader::read_bits(int bits)
+{
+	if (_overflow || _bit_index + bits > _size_bits)
+	{
+		_overflow = true;
+		return 0;
+	}
+	uint32_t value = 0;
+	int shift = 0;
+	while (bits > 0)
+	{
+		int byte = _bit_index >> 3;
+		int offset = _bit_index & 7;
+		int count = 8 - offset < bits ? 8 - offset : bits;
+		uint32_t mask = (1u << count) - 1;
+		value |= ((_buffer[byte] >> offset) & mask) << shift;
+		shift += count;
+		bits -= count;
+		_bit_index += count;
+	}
+	return value;
+}
+
+bool ga_bit_reader::read_bool()
+{
+	return read_bits(1) != 0;
+}
+
+uint32_t ga_bit_reader::read_varint()
+{
+	uint32_t value = 0;
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		uint32_t group = read_bits(8);
+		value |= (group & 0x7f) << shift;
+		if ((group & 0x80) == 0)
+		{
+			break;
+		}
+	}
+	return value;
+}
+
+float ga_bit_reader::read_float()
+{
+	uint32_t bits = read_bits(32);
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+int ga_bit_reader::get_bits_read() const
+{
+	return _bit_index;
+}
+
+int ga_bit_reader::get_bits_remaining() const
+{
+	return _size_bits - _bit_index;
+}
+
+bool ga_bit_reader::overflowed() const
+{
+	return _overflow;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+
+/*
+** Packs values into a caller-owned byte buffer at bit granularity.
+** Never allocates. Writing past the end of the buffer sets the overflow flag
+** and drops the value instead of corrupting memory.
+*/
+class ga_bit_writer
+{
+public:
+	ga_bit_writer(void* buffer, int size);
+
+	void write_bits(uint32_t value, int bits);
+	void write_bool(bool value);
+	void write_varint(uint32_t value);
+	void write_float(float value);
+
+	int get_bits_written() const;
+	int get_bytes_written() const;
+	bool overflowed() const;
+private:
+	uint8_t* _buffer;
+	int _size_bits;
+	int _bit_index;
+	bool _overflow;
+};
+
+/*
+** Reads values written by ga_bit_writer back out of a byte buffer.
+** Reading past the end of the buffer sets the overflow flag and returns zero.
+*/
+class ga_bit_reader
+{
+public:
+	ga_bit_reader(const void* buffer, int size);
+
+	uint32_t read_bits(int bits);
+	bool read_bool();
+	uint32_t read_varint();
+	float read_float();
+
+	int get_bits_read() const;
+	int get_bits_remaining() const;
+	bool overflowed() const;
+private:
+	const uint8_t* _buffer;
+	int _size_bits;
+	int _bit_index;
+	bool _overflow;
+};
@@ -0,0 +1,42 @@
+#include "ga_bitstream.tests.h"
+#include "ga_bitstream.h"
+
+#include <cassert>
+
+void ga_bitstream_unit_tests()
+{
+	// Test mixed width values round trip.
+	{
+		unsigned char buffer[64];
+		ga_bit_writer writer(buffer, sizeof(buffer));
+		writer.write_bits(5, 3);
+		writer.write_bool(true);
+		writer.write_varint(300);
+		writer.write_float(-1.5f);
+		writer.write_bits(0xdeadbeef, 32);
+		assert(!writer.overflowed());
+		assert(writer.get_bits_written() == 3 + 1 + 16 + 32 + 32);
+
+		ga_bit_reader reader(buffer, writer.get_bytes_written());
+		assert(reader.read_bits(3) == 5);
+		assert(reader.read_bool());
+		assert(reader.read_varint() == 300);
+		assert(reader.read_float() == -1.5f);
+		assert(reader.read_bits(32) == 0xdeadbeef);
+		assert(!reader.overflowed());
+	}
+
+	// Test overflow is flagged instead of writing or reading past the end.
+	{
+		unsigned char buffer[2];
+		ga_bit_writer writer(buffer, sizeof(buffer));
+		writer.write_bits(0xff, 8);
+		writer.write_bits(0xfff, 12);
+		assert(writer.overflowed());
+
+		ga_bit_reader reader(buffer, sizeof(buffer));
+		reader.read_bits(12);
+		reader.read_bits(8);
+		assert(reader.overflowed());
+	}
+}
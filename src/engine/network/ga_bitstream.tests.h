@@ -0,0 +1,3 @@
+#pragma once
+
+void ga_bitstream_unit_tests();
@@ -0,0 +1,125 @@
+#include "ga_client_table.h"
+
+static const int k_empty_bucket = -1;
+
+static unsigned int hash_address(const ga_address& address);
+static bool same_address(const ga_address& a, const ga_address& b);
+
+ga_client_table::ga_client_table(int max_clients)
+{
+	int bucket_count = 1;
+	while (bucket_count < max_clients * 2)
+	{
+		bucket_count <<= 1;
+	}
+	_buckets.assign(bucket_count, k_empty_bucket);
+	_mask = bucket_count - 1;
+	_addresses.resize(max_clients);
+	_used.assign(max_clients, false);
+	// Hand out low slots first
+	for (int slot = max_clients - 1; slot >= 0; slot--)
+	{
+		_free_slots.push_back(slot);
+	}
+}
+
+int ga_client_table::find(const ga_address& address) const
+{
+	int bucket = find_bucket(address);
+	return bucket == -1 ? -1 : _buckets[bucket];
+}
+
+int ga_client_table::insert(const ga_address& address)
+{
+	if (_free_slots.empty() || find_bucket(address) != -1)
+	{
+		return -1;
+	}
+	int slot = _free_slots.back();
+	_free_slots.pop_back();
+	_addresses[slot] = address;
+	_used[slot] = true;
+
+	int bucket = hash_address(address) & _mask;
+	while (_buckets[bucket] != k_empty_bucket)
+	{
+		bucket = (bucket + 1) & _mask;
+	}
+	_buckets[bucket] = slot;
+	return slot;
+}
+
+void ga_client_table::remove(int slot)
+{
+	int bucket = find_bucket(_addresses[slot]);
+	if (!_used[slot] || bucket == -1)
+	{
+		return;
+	}
+	_used[slot] = false;
+	_free_slots.push_back(slot);
+
+	// Shift later entries of the probe chain back into the hole, so lookups
+	// never need tombstones
+	_buckets[bucket] = k_empty_bucket;
+	int next = (bucket + 1) & _mask;
+	while (_buckets[next] != k_empty_bucket)
+	{
+		int home = hash_address(_addresses[_buckets[next]]) & _mask;
+		if (((next - home) & _mask) >= ((next - bucket) & _mask))
+		{
+			_buckets[bucket] = _buckets[next];
+			_buckets[next] = k_empty_bucket;
+			bucket = next;
+		}
+		next = (next + 1) & _mask;
+	}
+}
+
+int ga_client_table::get_max_clients() const
+{
+	return _addresses.size();
+}
+
+int ga_client_table::get_client_count() const
+{
+	return _addresses.size() - _free_slots.size();
+}
+
+bool ga_client_table::is_used(int slot) const
+{
+	return _used[slot];
+}
+
+const ga_address& ga_client_table::get_address(int slot) const
+{
+	return _addresses[slot];
+}
+
+int ga_client_table::find_bucket(const ga_address& address) const
+{
+	int bucket = hash_address(address) & _mask;
+	while (_buckets[bucket] != k_empty_bucket)
+	{
+		if (same_address(_addresses[_buckets[bucket]], address))
+		{
+			return bucket;
+		}
+		bucket = (bucket + 1) & _mask;
+	}
+	return -1;
+}
+
+static unsigned int hash_address(const ga_address& address)
+{
+	// Mix so clients on one host with consecutive ports spread out
+	unsigned int h = address.get_address() * 0x9e3779b1u;
+	h ^= address.get_port() * 0x85ebca6bu;
+	h ^= h >> 16;
+	return h;
+}
+
+static bool same_address(const ga_address& a, const ga_address& b)
+{
+	return a.get_address() == b.get_address() && a.get_port() == b.get_port();
+}
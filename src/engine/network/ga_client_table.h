@@ -0,0 +1,35 @@
+#pragma once
+#include "ga_address.h"
+#include <vector>
+
+/*
+** Maps client addresses to stable slot indices in constant time.
+** Open addressing with linear probing over a power of two bucket array at
+** most half full. Slots freed by remove() are handed out again by insert().
+*/
+class ga_client_table
+{
+public:
+	ga_client_table(int max_clients);
+
+	// Returns the slot for the address, or -1 if it has none.
+	int find(const ga_address& address) const;
+
+	// Claims a free slot for the address. Returns -1 if the table is full.
+	int insert(const ga_address& address);
+	void remove(int slot);
+
+	int get_max_clients() const;
+	int get_client_count() const;
+	bool is_used(int slot) const;
+	const ga_address& get_address(int slot) const;
+
+private:
+	int find_bucket(const ga_address& address) const;
+
+	std::vector<int> _buckets;
+	std::vector<ga_address> _addresses;
+	std::vector<bool> _used;
+	std::vector<int> _free_slots;
+	int _mask;
+};
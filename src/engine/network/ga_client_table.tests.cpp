@@ -0,0 +1,36 @@
+#include "ga_client_table.tests.h"
+#include "ga_client_table.h"
+
+#include <cassert>
+
+void ga_client_table_unit_tests()
+{
+	// Test lookups survive removals in the middle of probe chains.
+	{
+		const int k_clients = 300;
+		ga_client_table table(k_clients);
+		for (int i = 0; i < k_clients; i++)
+		{
+			assert(table.insert(ga_address(127, 0, 0, 1, 9000 + i)) == i);
+		}
+		assert(table.insert(ga_address(127, 0, 0, 2, 9000)) == -1);
+		assert(table.insert(ga_address(127, 0, 0, 1, 9000)) == -1);
+
+		for (int i = 0; i < k_clients; i += 3)
+		{
+			table.remove(i);
+		}
+		assert(table.get_client_count() == k_clients - k_clients / 3);
+		for (int i = 0; i < k_clients; i++)
+		{
+			int slot = table.find(ga_address(127, 0, 0, 1, 9000 + i));
+			assert(i % 3 == 0 ? slot == -1 : slot == i);
+		}
+
+		// Freed slots are reused, other clients keep theirs.
+		int slot = table.insert(ga_address(10, 0, 0, 1, 5000));
+		assert(slot != -1 && slot % 3 == 0);
+		assert(table.find(ga_address(10, 0, 0, 1, 5000)) == slot);
+		assert(table.find(ga_address(127, 0, 0, 1, 9001)) == 1);
+	}
+}
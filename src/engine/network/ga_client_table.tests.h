@@ -0,0 +1,3 @@
+#pragma once
+
+void ga_client_table_unit_tests();
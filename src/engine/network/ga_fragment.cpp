@@ -0,0 +1,114 @@
+#include "ga_fragment.h"
+#include "ga_bitstream.h"
+#include <cstring>
+
+int ga_fragment_count(int size, int mtu)
+{
+	int fragment_size = mtu - FRAGMENT_HEADER_SIZE;
+	int count = (size + fragment_size - 1) / fragment_size;
+	return count > 0 ? count : 1;
+}
+
+int ga_write_fragment(uint16_t sequence, const void* payload, int size, int index, int mtu, void* out)
+{
+	int fragment_size = mtu - FRAGMENT_HEADER_SIZE;
+	int count = ga_fragment_count(size, mtu);
+	int offset = index * fragment_size;
+	int length = size - offset < fragment_size ? size - offset : fragment_size;
+
+	ga_bit_writer writer(out, FRAGMENT_HEADER_SIZE);
+	writer.write_bits(sequence, 16);
+	writer.write_bits(index, 8);
+	writer.write_bits(count, 8);
+	memcpy((uint8_t*)out + FRAGMENT_HEADER_SIZE, (const uint8_t*)payload + offset, length);
+	return FRAGMENT_HEADER_SIZE + length;
+}
+
+ga_reassembly_buffer::ga_reassembly_buffer(int mtu)
+{
+	_fragment_size = mtu - FRAGMENT_HEADER_SIZE;
+	_slab = new uint8_t[REASSEMBLY_SLOTS * MAX_FRAGMENTS * _fragment_size];
+	for (int i = 0; i < REASSEMBLY_SLOTS; i++)
+	{
+		_slots[i]._used = false;
+		_slots[i]._data = _slab + i * MAX_FRAGMENTS * _fragment_size;
+	}
+	_has_completed = false;
+	_last_completed = 0;
+}
+
+ga_reassembly_buffer::~ga_reassembly_buffer()
+{
+	delete[] _slab;
+}
+
+int ga_reassembly_buffer::add_fragment(const void* data, int size, const uint8_t** payload)
+{
+	if (size < FRAGMENT_HEADER_SIZE)
+	{
+		return 0;
+	}
+	ga_bit_reader reader(data, FRAGMENT_HEADER_SIZE);
+	uint16_t sequence = reader.read_bits(16);
+	int index = reader.read_bits(8);
+	int count = reader.read_bits(8);
+	int length = size - FRAGMENT_HEADER_SIZE;
+	if (count == 0 || count > MAX_FRAGMENTS || index >= count || length > _fragment_size ||
+		(index < count - 1 && length != _fragment_size))
+	{
+		return 0;
+	}
+	// Anything not newer than the last completed payload is stale
+	if (_has_completed && !ga_sequence_greater(sequence, _last_completed))
+	{
+		return 0;
+	}
+
+	slot_t& slot = _slots[sequence % REASSEMBLY_SLOTS];
+	if (!slot._used || slot._sequence != sequence)
+	{
+		if (slot._used && ga_sequence_greater(slot._sequence, sequence))
+		{
+			return 0;
+		}
+		slot._used = true;
+		slot._sequence = sequence;
+		slot._count = count;
+		slot._received = 0;
+		slot._size = 0;
+		slot._mask = 0;
+	}
+	if (slot._count != count || (slot._mask & (1ull << index)))
+	{
+		return 0;
+	}
+	memcpy(slot._data + index * _fragment_size, (const uint8_t*)data + FRAGMENT_HEADER_SIZE, length);
+	slot._mask |= 1ull << index;
+	slot._received++;
+	if (index == count - 1)
+	{
+		slot._size = index * _fragment_size + length;
+	}
+	if (slot._received < slot._count)
+	{
+		return 0;
+	}
+
+	// Complete. Drop every older payload still being assembled.
+	_has_completed = true;
+	_last_completed = sequence;
+	for (int i = 0; i < REASSEMBLY_SLOTS; i++)
+	{
+		if (_slots[i]._used && !ga_sequence_greater(_slots[i]._sequence, sequence))
+		{
+			_slots[i]._used = false;
+		}
+	}
+	*payload = slot._data;
+	return slot._size;
+}
+
+uint16_t ga_reassembly_buffer::get_last_completed() const
+{
+	return _last_completed;
+}
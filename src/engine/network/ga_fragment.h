@@ -0,0 +1,52 @@
+#pragma once
+#include "ga_packet_header.h"
+#include <cstdint>
+
+#define DEFAULT_MTU 1200
+#define MAX_FRAGMENTS 64
+#define FRAGMENT_HEADER_SIZE 4
+#define REASSEMBLY_SLOTS 4
+
+/*
+** Splits payloads larger than the MTU into fragments.
+** Each fragment is prefixed with [16 bit sequence][8 bit index][8 bit count].
+*/
+int ga_fragment_count(int size, int mtu);
+int ga_write_fragment(uint16_t sequence, const void* payload, int size, int index, int mtu, void* out);
+
+/*
+** Reassembles fragmented payloads into a slab allocated up front.
+** Only the newest payloads are kept: when one completes, any older
+** incomplete ones are dropped, and fragments older than it are ignored.
+*/
+class ga_reassembly_buffer
+{
+public:
+	ga_reassembly_buffer(int mtu);
+	~ga_reassembly_buffer();
+
+	// Returns the size of the payload completed by this fragment, or 0.
+	// The payload stays valid until the next call.
+	int add_fragment(const void* data, int size, const uint8_t** payload);
+
+	// Sequence of the payload most recently completed.
+	uint16_t get_last_completed() const;
+
+private:
+	struct slot_t
+	{
+		bool _used;
+		uint16_t _sequence;
+		int _count;
+		int _received;
+		int _size;
+		uint64_t _mask;
+		uint8_t* _data;
+	};
+
+	slot_t _slots[REASSEMBLY_SLOTS];
+	uint8_t* _slab;
+	int _fragment_size;
+	bool _has_completed;
+	uint16_t _last_completed;
+};
@@ -0,0 +1,54 @@
+#include "ga_fragment.tests.h"
+#include "ga_fragment.h"
+
+#include <cassert>
+
+void ga_fragment_unit_tests()
+{
+	const int k_mtu = 20;
+	unsigned char payload[100];
+	for (int i = 0; i < (int)sizeof(payload); i++)
+	{
+		payload[i] = (unsigned char)i;
+	}
+	int count = ga_fragment_count(sizeof(payload), k_mtu);
+	assert(count == 7);
+
+	// Test fragments arriving out of order are reassembled.
+	{
+		ga_reassembly_buffer reassembly(k_mtu);
+		const uint8_t* result = 0;
+		int size = 0;
+		for (int f = count - 1; f >= 0; f--)
+		{
+			unsigned char packet[k_mtu];
+			int length = ga_write_fragment(7, payload, sizeof(payload), f, k_mtu, packet);
+			assert(length <= k_mtu);
+			size = reassembly.add_fragment(packet, length, &result);
+			assert(f == 0 || size == 0);
+		}
+		assert(size == sizeof(payload));
+		for (int i = 0; i < size; i++)
+		{
+			assert(result[i] == payload[i]);
+		}
+	}
+
+	// Test an incomplete older payload is dropped once a newer one completes.
+	{
+		ga_reassembly_buffer reassembly(k_mtu);
+		const uint8_t* result = 0;
+		unsigned char packet[k_mtu];
+		int length = ga_write_fragment(1, payload, sizeof(payload), 0, k_mtu, packet);
+		assert(reassembly.add_fragment(packet, length, &result) == 0);
+
+		length = ga_write_fragment(2, payload, 10, 0, k_mtu, packet);
+		assert(reassembly.add_fragment(packet, length, &result) == 10);
+
+		for (int f = 1; f < count; f++)
+		{
+			length = ga_write_fragment(1, payload, sizeof(payload), f, k_mtu, packet);
+			assert(reassembly.add_fragment(packet, length, &result) == 0);
+		}
+	}
+}
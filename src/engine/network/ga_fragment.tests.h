@@ -0,0 +1,3 @@
+#pragma once
+
+void ga_fragment_unit_tests();
@@ -0,0 +1,68 @@
+#include "ga_input_command.h"
+#include "ga_bitstream.h"
+#include "framework/ga_frame_params.h"
+
+void ga_apply_input_command(const ga_input_command& command, ga_mat4f* transform)
+{
+	ga_vec3f trans = ga_vec3f::zero_vector();
+	if (command._buttons & k_button_j)
+	{
+		trans.x = -0.2f;
+	}
+	else if (command._buttons & k_button_l)
+	{
+		trans.x = 0.2f;
+	}
+	else if (command._buttons & k_button_i)
+	{
+		trans.z = -0.2f;
+	}
+	else if (command._buttons & k_button_k)
+	{
+		trans.z = 0.2f;
+	}
+	transform->translate(trans);
+}
+
+void ga_write_input_batch(const ga_input_command* history, uint16_t newest, int count, ga_bit_writer* writer)
+{
+	writer->write_bits(count, 8);
+	writer->write_bits(newest, 16);
+	for (int i = 0; i < count; i++)
+	{
+		const ga_input_command& command = history[(uint16_t)(newest - i) % INPUT_HISTORY_SIZE];
+		if (i > 0)
+		{
+			const ga_input_command& newer = history[(uint16_t)(newest - i + 1) % INPUT_HISTORY_SIZE];
+			bool same = command._buttons == newer._buttons;
+			writer->write_bool(same);
+			if (same)
+			{
+				continue;
+			}
+		}
+		writer->write_varint(command._buttons);
+	}
+}
+
+int ga_read_input_batch(ga_bit_reader* reader, ga_input_command* commands)
+{
+	int count = reader->read_bits(8);
+	uint16_t newest = reader->read_bits(16);
+	if (count == 0 || count > INPUT_REDUNDANCY)
+	{
+		return 0;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		ga_input_command& command = commands[count - 1 - i];
+		command._number = newest - i;
+		if (i > 0 && reader->read_bool())
+		{
+			command._buttons = commands[count - i]._buttons;
+			continue;
+		}
+		command._buttons = reader->read_varint();
+	}
+	return reader->overflowed() ? 0 : count;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "math/ga_mat4f.h"
+#include <cstdint>
+
+#define INPUT_HISTORY_SIZE 64
+#define INPUT_REDUNDANCY 8
+#define NO_PLAYER_ENTITY 0xffff
+
+// Snapshot packets start, after the packet header, with the number of the
+// last input the server applied for that client and the entity it controls.
+#define SNAPSHOT_INFO_SIZE 4
+
+/*
+** One tick of player input, numbered so the server can tell the client
+** which inputs its snapshots already include.
+*/
+struct ga_input_command
+{
+	uint16_t _number;
+	uint32_t _buttons;
+};
+
+/*
+** Moves a player by one input command. Shared by the server and the
+** client's prediction so both arrive at the same result.
+*/
+void ga_apply_input_command(const ga_input_command& command, ga_mat4f* transform);
+
+/*
+** Every input packet repeats the newest few inputs the server has not applied
+** yet, so a lost packet is covered by the next one without a resend.
+** Written newest first as [8 bit count][16 bit newest number], then the
+** buttons of each, one bit if unchanged from the newer one or a varint.
+** History is indexed by number modulo INPUT_HISTORY_SIZE.
+*/
+void ga_write_input_batch(const ga_input_command* history, uint16_t newest, int count, class ga_bit_writer* writer);
+
+// Reads up to INPUT_REDUNDANCY commands, oldest first. Returns 0 if malformed.
+int ga_read_input_batch(class ga_bit_reader* reader, ga_input_command* commands);
@@ -0,0 +1,50 @@
+#include "ga_input_command.tests.h"
+#include "ga_input_command.h"
+
+#include "ga_bitstream.h"
+#include "framework/ga_frame_params.h"
+
+#include <cassert>
+
+void ga_input_command_unit_tests()
+{
+	// Test a batch reads back oldest first, across the history wrapping.
+	{
+		ga_input_command history[INPUT_HISTORY_SIZE];
+		uint32_t buttons[] = { 0, k_button_j, k_button_j, k_button_z | k_button_i };
+		for (int i = 0; i < 4; i++)
+		{
+			uint16_t number = 0xfffe + i;
+			history[number % INPUT_HISTORY_SIZE]._number = number;
+			history[number % INPUT_HISTORY_SIZE]._buttons = buttons[i];
+		}
+
+		unsigned char buffer[32];
+		ga_bit_writer writer(buffer, sizeof(buffer));
+		ga_write_input_batch(history, 1, 4, &writer);
+		assert(!writer.overflowed());
+
+		ga_input_command commands[INPUT_REDUNDANCY];
+		ga_bit_reader reader(buffer, writer.get_bytes_written());
+		assert(ga_read_input_batch(&reader, commands) == 4);
+		for (int i = 0; i < 4; i++)
+		{
+			assert(commands[i]._number == (uint16_t)(0xfffe + i));
+			assert(commands[i]._buttons == buttons[i]);
+		}
+	}
+
+	// Test truncated batches are rejected.
+	{
+		ga_input_command history[INPUT_HISTORY_SIZE];
+		history[5]._number = 5;
+		history[5]._buttons = 0xffffffff;
+		unsigned char buffer[32];
+		ga_bit_writer writer(buffer, sizeof(buffer));
+		ga_write_input_batch(history, 5, 1, &writer);
+
+		ga_input_command commands[INPUT_REDUNDANCY];
+		ga_bit_reader reader(buffer, writer.get_bytes_written() - 1);
+		assert(ga_read_input_batch(&reader, commands) == 0);
+	}
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void ga_input_command_unit_tests();
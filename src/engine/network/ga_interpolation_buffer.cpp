@@ -0,0 +1,135 @@
+#include "ga_interpolation_buffer.h"
+
+ga_interpolation_buffer::ga_interpolation_buffer(int num_entities)
+{
+	for (int i = 0; i < INTERPOLATION_BUFFER_SIZE; i++)
+	{
+		_entries[i]._snapshot = ga_snapshot(num_entities);
+		_entries[i]._tick = 0;
+	}
+	_count = 0;
+	_newest = 0;
+	_tick_interval = std::chrono::duration_cast<duration>(std::chrono::microseconds(1000000 / 60));
+	_delay = std::chrono::duration_cast<duration>(std::chrono::milliseconds(100));
+	_extrapolation_limit = std::chrono::duration_cast<duration>(std::chrono::milliseconds(100));
+	_has_offset = false;
+	_clock_offset = duration::zero();
+	_from = NULL;
+	_to = NULL;
+	_alpha = 0.0f;
+}
+
+void ga_interpolation_buffer::set_tick_interval(duration interval)
+{
+	_tick_interval = interval;
+}
+
+void ga_interpolation_buffer::set_delay(duration delay)
+{
+	_delay = delay;
+}
+
+void ga_interpolation_buffer::set_extrapolation_limit(duration limit)
+{
+	_extrapolation_limit = limit;
+}
+
+void ga_interpolation_buffer::add(const ga_snapshot& snapshot, uint16_t sequence, time_point received)
+{
+	// Unwrap the 16 bit sequence against the newest tick we hold
+	int64_t tick = sequence;
+	if (_count > 0)
+	{
+		int64_t newest = _entries[_newest]._tick;
+		tick = newest + (int16_t)(sequence - (uint16_t)newest);
+		if (tick <= newest)
+		{
+			return;
+		}
+	}
+	_newest = (_newest + 1) % INTERPOLATION_BUFFER_SIZE;
+	_count = _count < INTERPOLATION_BUFFER_SIZE ? _count + 1 : _count;
+	_entries[_newest]._snapshot = snapshot;
+	_entries[_newest]._tick = tick;
+
+	// Late arrivals only pull the offset up slowly, so jitter is absorbed by
+	// the delay instead of shaking the timeline
+	duration offset = received.time_since_epoch() - tick_to_time(tick);
+	if (!_has_offset || offset < _clock_offset)
+	{
+		_clock_offset = offset;
+		_has_offset = true;
+	}
+	else
+	{
+		_clock_offset += (offset - _clock_offset) / 16;
+	}
+}
+
+bool ga_interpolation_buffer::set_time(time_point now)
+{
+	if (_count == 0)
+	{
+		return false;
+	}
+	duration render_time = now.time_since_epoch() - _clock_offset - _delay;
+
+	// Walk back from the newest to find the snapshot at or before render time
+	const entry_t* newer = &_entries[_newest];
+	for (int i = 1; i < _count; i++)
+	{
+		const entry_t* older = &_entries[(_newest - i + INTERPOLATION_BUFFER_SIZE) % INTERPOLATION_BUFFER_SIZE];
+		duration older_time = tick_to_time(older->_tick);
+		if (older_time <= render_time || i == _count - 1)
+		{
+			duration span = tick_to_time(newer->_tick) - older_time;
+			duration elapsed = render_time - older_time;
+			if (newer == &_entries[_newest] && elapsed > span + _extrapolation_limit)
+			{
+				elapsed = span + _extrapolation_limit;
+			}
+			_from = &older->_snapshot;
+			_to = &newer->_snapshot;
+			_alpha = std::chrono::duration<float>(elapsed) / std::chrono::duration<float>(span);
+			_alpha = _alpha < 0.0f ? 0.0f : _alpha;
+			return true;
+		}
+		newer = older;
+	}
+
+	// Only one snapshot so far
+	_from = &_entries[_newest]._snapshot;
+	_to = _from;
+	_alpha = 0.0f;
+	return true;
+}
+
+ga_mat4f ga_interpolation_buffer::get_transform(int e) const
+{
+	// Entities that just spawned have nothing to blend from
+	ga_mat4f to = _to->get_transform(e);
+	if (_to == _from || !_from->is_live(e))
+	{
+		return to;
+	}
+	ga_mat4f from = _from->get_transform(e);
+	ga_mat4f blended;
+	blended.make_rotation(ga_quatf_nlerp(from.get_rotation(), to.get_rotation(), _alpha));
+	blended.set_translation(ga_vec3f_lerp(from.get_translation(), to.get_translation(), _alpha));
+	return blended;
+}
+
+bool ga_interpolation_buffer::is_live(int e) const
+{
+	return _to->is_live(e);
+}
+
+int ga_interpolation_buffer::num_entities() const
+{
+	return _to->num_entities();
+}
+
+ga_interpolation_buffer::duration ga_interpolation_buffer::tick_to_time(int64_t tick) const
+{
+	return _tick_interval * tick;
+}
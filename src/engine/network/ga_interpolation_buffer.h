@@ -0,0 +1,62 @@
+#pragma once
+#include "framework/ga_snapshot.h"
+#include <chrono>
+#include <cstdint>
+
+#define INTERPOLATION_BUFFER_SIZE 32
+
+/*
+** Received snapshots, stamped with the server tick they were taken on.
+** Entities are rendered a fixed delay behind the newest snapshot so there is
+** normally a later one to blend towards. When snapshots stop arriving the
+** last two are extrapolated for a limited time, then held.
+*/
+class ga_interpolation_buffer
+{
+public:
+	typedef std::chrono::high_resolution_clock::duration duration;
+	typedef std::chrono::high_resolution_clock::time_point time_point;
+
+	ga_interpolation_buffer(int num_entities);
+
+	void set_tick_interval(duration interval);
+	void set_delay(duration delay);
+	void set_extrapolation_limit(duration limit);
+
+	// Snapshots older than the newest one added are ignored.
+	void add(const ga_snapshot& snapshot, uint16_t sequence, time_point received);
+
+	// Picks the snapshots to blend for the given local time. Returns false
+	// until there is anything to show.
+	bool set_time(time_point now);
+	ga_mat4f get_transform(int e) const;
+
+	// Whether e exists at the time picked, and how many ids there may be.
+	bool is_live(int e) const;
+	int num_entities() const;
+
+private:
+	struct entry_t
+	{
+		ga_snapshot _snapshot;
+		int64_t _tick;
+	};
+
+	duration tick_to_time(int64_t tick) const;
+
+	entry_t _entries[INTERPOLATION_BUFFER_SIZE];
+	int _count;
+	int _newest;
+
+	duration _tick_interval;
+	duration _delay;
+	duration _extrapolation_limit;
+
+	// Estimate of local clock minus server clock, taken from the fastest arrivals
+	bool _has_offset;
+	duration _clock_offset;
+
+	const ga_snapshot* _from;
+	const ga_snapshot* _to;
+	float _alpha;
+};
@@ -0,0 +1,39 @@
+#include "ga_interpolation_buffer.tests.h"
+#include "ga_interpolation_buffer.h"
+
+#include "entity/ga_entity.h"
+
+#include <cassert>
+#include <cmath>
+
+void ga_interpolation_buffer_unit_tests()
+{
+	// Test entities are blended a fixed delay behind the newest snapshot.
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		auto ms = [start](int count) { return start + std::chrono::milliseconds(count); };
+
+		ga_entity box;
+		ga_snapshot first(1);
+		first.add_entity(0, box);
+		box.translate({ 1.0f, 0.0f, 0.0f });
+		ga_snapshot second(1);
+		second.add_entity(0, box);
+
+		// Ticks are 1/60th of a second, so tick 6 is taken 100ms after tick 0.
+		ga_interpolation_buffer buffer(1);
+		assert(!buffer.set_time(ms(0)));
+		buffer.add(first, 0, ms(0));
+		buffer.add(second, 6, ms(100));
+		buffer.add(first, 3, ms(110));
+
+		assert(buffer.set_time(ms(0)));
+		assert(ga_equalf(buffer.get_transform(0).get_translation().x, 0.0f));
+		assert(buffer.set_time(ms(150)));
+		assert(fabsf(buffer.get_transform(0).get_translation().x - 0.5f) < 0.01f);
+
+		// Extrapolation stops at the limit.
+		assert(buffer.set_time(ms(5000)));
+		assert(fabsf(buffer.get_transform(0).get_translation().x - 2.0f) < 0.01f);
+	}
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void ga_interpolation_buffer_unit_tests();
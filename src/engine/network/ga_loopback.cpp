@@ -0,0 +1,203 @@
+#include "ga_loopback.h"
+#include <algorithm>
+#include <cstring>
+
+static uint64_t address_key(const ga_address& address);
+static bool delivered_later(const ga_loopback_packet& a, const ga_loopback_packet& b);
+
+ga_loopback_network::ga_loopback_network(uint32_t seed, int packet_count)
+{
+	_random = seed != 0 ? seed : 1;
+	_order = 0;
+	_frozen = false;
+	_pool = new ga_packet_pool(packet_count);
+}
+
+ga_loopback_network::~ga_loopback_network()
+{
+	delete _pool;
+}
+
+void ga_loopback_network::set_conditions(const ga_link_conditions& conditions)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_conditions = conditions;
+}
+
+void ga_loopback_network::set_time(std::chrono::high_resolution_clock::time_point time)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_frozen = true;
+	_time = time;
+	_condvar.notify_all();
+}
+
+std::chrono::high_resolution_clock::time_point ga_loopback_network::now() const
+{
+	return _frozen ? _time : std::chrono::high_resolution_clock::now();
+}
+
+float ga_loopback_network::random()
+{
+	// xorshift32, uniform in [0, 1)
+	_random ^= _random << 13;
+	_random ^= _random >> 17;
+	_random ^= _random << 5;
+	return (_random >> 8) * (1.0f / 16777216.0f);
+}
+
+void ga_loopback_network::add(ga_loopback_transport* transport)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_transports[address_key(transport->_address)] = transport;
+}
+
+void ga_loopback_network::remove(ga_loopback_transport* transport)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_transports.erase(address_key(transport->_address));
+	for (ga_loopback_packet& pending : transport->_in_flight)
+	{
+		_pool->free(pending._packet);
+	}
+	transport->_in_flight.clear();
+}
+
+void ga_loopback_network::send(const ga_address& from, const ga_packet& packet)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	// Like UDP, anything sent to an address nobody is bound to is lost
+	auto found = _transports.find(address_key(packet._address));
+	if (found == _transports.end() || random() < _conditions._loss)
+	{
+		return;
+	}
+	std::vector<ga_loopback_packet>& in_flight = found->second->_in_flight;
+	int copies = random() < _conditions._duplicate ? 2 : 1;
+	for (int i = 0; i < copies; i++)
+	{
+		int delay_ms = _conditions._latency_ms;
+		delay_ms += (int)(random() * (_conditions._jitter_ms + 1));
+		if (random() < _conditions._reorder)
+		{
+			delay_ms += _conditions._reorder_delay_ms;
+		}
+		ga_loopback_packet sent;
+		sent._packet = _pool->alloc();
+		if (!sent._packet)
+		{
+			break;
+		}
+		sent._deliver = now() + std::chrono::milliseconds(delay_ms);
+		sent._order = _order++;
+		sent._packet->_address = from;
+		sent._packet->_size = packet._size;
+		memcpy(sent._packet->_data, packet._data, packet._size);
+		in_flight.push_back(sent);
+		std::push_heap(in_flight.begin(), in_flight.end(), delivered_later);
+	}
+	_condvar.notify_all();
+}
+
+int ga_loopback_network::receive(ga_loopback_transport* transport, ga_packet* const* packets, int count)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	std::vector<ga_loopback_packet>& in_flight = transport->_in_flight;
+	auto time = now();
+	int received = 0;
+	while (received < count && !in_flight.empty() && in_flight.front()._deliver <= time)
+	{
+		std::pop_heap(in_flight.begin(), in_flight.end(), delivered_later);
+		ga_loopback_packet& arrived = in_flight.back();
+		ga_packet* packet = packets[received++];
+		packet->_address = arrived._packet->_address;
+		packet->_time = time;
+		packet->_size = arrived._packet->_size;
+		memcpy(packet->_data, arrived._packet->_data, arrived._packet->_size);
+		_pool->free(arrived._packet);
+		in_flight.pop_back();
+	}
+	return received;
+}
+
+bool ga_loopback_network::wait(ga_loopback_transport* transport, int timeout_ms)
+{
+	// Wake for new packets, for the next delivery or for the clock moving
+	std::unique_lock<std::mutex> lock(_mutex);
+	std::vector<ga_loopback_packet>& in_flight = transport->_in_flight;
+	auto deadline = std::chrono::high_resolution_clock::now() + std::chrono::milliseconds(timeout_ms);
+	for (;;)
+	{
+		if (!in_flight.empty() && in_flight.front()._deliver <= now())
+		{
+			return true;
+		}
+		auto wake = deadline;
+		if (!_frozen && !in_flight.empty() && in_flight.front()._deliver < wake)
+		{
+			wake = in_flight.front()._deliver;
+		}
+		if (std::chrono::high_resolution_clock::now() >= deadline)
+		{
+			return false;
+		}
+		_condvar.wait_until(lock, wake);
+	}
+}
+
+ga_loopback_transport::ga_loopback_transport(ga_loopback_network* network, const ga_address& address)
+{
+	_network = network;
+	_address = address;
+	_network->add(this);
+}
+
+ga_loopback_transport::~ga_loopback_transport()
+{
+	_network->remove(this);
+}
+
+const ga_address& ga_loopback_transport::get_address() const
+{
+	return _address;
+}
+
+int ga_loopback_transport::send_batch(ga_packet* const* packets, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		_network->send(_address, *packets[i]);
+	}
+	return count;
+}
+
+int ga_loopback_transport::receive_batch(ga_packet* const* packets, int count)
+{
+	return _network->receive(this, packets, count);
+}
+
+bool ga_loopback_transport::wait(int timeout_ms)
+{
+	return _network->wait(this, timeout_ms);
+}
+
+int ga_loopback_transport::get_handle() const
+{
+	return -1;
+}
+
+static uint64_t address_key(const ga_address& address)
+{
+	return ((uint64_t)address.get_address() << 16) | address.get_port();
+}
+
+static bool delivered_later(const ga_loopback_packet& a, const ga_loopback_packet& b)
+{
+	// Heap comparator: the earliest delivery, then the earliest sent, is on top
+	if (a._deliver != b._deliver)
+	{
+		return a._deliver > b._deliver;
+	}
+	return a._order > b._order;
+}
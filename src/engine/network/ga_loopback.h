@@ -0,0 +1,108 @@
+#pragma once
+#include "ga_transport.h"
+#include "ga_packet_pool.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Packets a loopback network can hold in flight before it drops new ones.
+#define LOOPBACK_PACKET_POOL_SIZE 4096
+
+/*
+** Conditions applied to every packet sent over a loopback network.
+** Probabilities are in [0, 1].
+*/
+struct ga_link_conditions
+{
+	int _latency_ms = 0;
+
+	// Extra delay, picked uniformly up to this, per packet.
+	int _jitter_ms = 0;
+
+	float _loss = 0.0f;
+	float _duplicate = 0.0f;
+
+	// Reordered packets are held back by _reorder_delay_ms on top of the rest.
+	float _reorder = 0.0f;
+	int _reorder_delay_ms = 10;
+};
+
+/*
+** A packet on its way through a loopback network.
+** The copy is taken from the network's pool and its address is the sender's.
+*/
+struct ga_loopback_packet
+{
+	std::chrono::high_resolution_clock::time_point _deliver;
+	uint64_t _order;
+	ga_packet* _packet;
+};
+
+/*
+** An in-process stand-in for the network that loopback transports send
+** through, by address. Losses, duplicates and delays come from a seeded
+** generator, so sending the same packets in the same order always gives the
+** same result. Runs on the real clock unless frozen with set_time.
+** Packets in flight are copied into a fixed pool; once it runs dry, sends
+** are dropped like a full socket buffer would.
+** Thread-safe.
+*/
+class ga_loopback_network
+{
+public:
+	ga_loopback_network(uint32_t seed, int packet_count = LOOPBACK_PACKET_POOL_SIZE);
+	~ga_loopback_network();
+
+	void set_conditions(const ga_link_conditions& conditions);
+	void set_time(std::chrono::high_resolution_clock::time_point time);
+
+private:
+	friend class ga_loopback_transport;
+
+	std::chrono::high_resolution_clock::time_point now() const;
+	float random();
+	void add(class ga_loopback_transport* transport);
+	void remove(class ga_loopback_transport* transport);
+	void send(const ga_address& from, const ga_packet& packet);
+	int receive(class ga_loopback_transport* transport, ga_packet* const* packets, int count);
+	bool wait(class ga_loopback_transport* transport, int timeout_ms);
+
+	std::mutex _mutex;
+	std::condition_variable _condvar;
+	ga_link_conditions _conditions;
+	uint32_t _random;
+	uint64_t _order;
+	bool _frozen;
+	std::chrono::high_resolution_clock::time_point _time;
+	std::unordered_map<uint64_t, class ga_loopback_transport*> _transports;
+	ga_packet_pool* _pool;
+};
+
+/*
+** One address on a loopback network. Has no handle, so a ga_poller cannot
+** wait on it and the network thread polls it instead.
+*/
+class ga_loopback_transport : public ga_transport
+{
+public:
+	ga_loopback_transport(ga_loopback_network* network, const ga_address& address);
+	virtual ~ga_loopback_transport();
+
+	const ga_address& get_address() const;
+
+	virtual int send_batch(ga_packet* const* packets, int count) override;
+	virtual int receive_batch(ga_packet* const* packets, int count) override;
+	virtual bool wait(int timeout_ms) override;
+	virtual int get_handle() const override;
+
+private:
+	friend class ga_loopback_network;
+
+	ga_loopback_network* _network;
+	ga_address _address;
+
+	// Heap ordered by delivery time, guarded by the network's mutex
+	std::vector<ga_loopback_packet> _in_flight;
+};
@@ -0,0 +1,95 @@
+#include "ga_loopback.tests.h"
+#include "ga_loopback.h"
+
+#include <cassert>
+
+void ga_loopback_unit_tests()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	ga_address a_address(127, 0, 0, 1, 1000);
+	ga_address b_address(127, 0, 0, 1, 1001);
+	ga_packet sent;
+	sent._address = b_address;
+	sent._size = 1;
+	ga_packet received;
+	ga_packet* send_batch[] = { &sent };
+	ga_packet* receive_batch[] = { &received };
+
+	// Test packets arrive from the sender's address once their latency passes.
+	{
+		ga_loopback_network network(1);
+		ga_link_conditions conditions;
+		conditions._latency_ms = 20;
+		network.set_conditions(conditions);
+		network.set_time(start);
+		ga_loopback_transport a(&network, a_address);
+		ga_loopback_transport b(&network, b_address);
+
+		sent._data[0] = 42;
+		assert(a.send_batch(send_batch, 1) == 1);
+		assert(b.receive_batch(receive_batch, 1) == 0);
+		network.set_time(start + std::chrono::milliseconds(20));
+		assert(b.wait(0));
+		assert(b.receive_batch(receive_batch, 1) == 1);
+		assert(received._size == 1 && received._data[0] == 42);
+		assert(received._address.get_port() == 1000);
+		assert(received._time == start + std::chrono::milliseconds(20));
+		assert(b.receive_batch(receive_batch, 1) == 0);
+	}
+
+	// Test certain loss drops everything and certain duplication doubles it.
+	{
+		ga_loopback_network network(1);
+		ga_loopback_transport a(&network, a_address);
+		ga_loopback_transport b(&network, b_address);
+		network.set_time(start);
+		ga_link_conditions conditions;
+		conditions._loss = 1.0f;
+		network.set_conditions(conditions);
+		a.send_batch(send_batch, 1);
+		assert(b.receive_batch(receive_batch, 1) == 0);
+
+		conditions._loss = 0.0f;
+		conditions._duplicate = 1.0f;
+		network.set_conditions(conditions);
+		a.send_batch(send_batch, 1);
+		assert(b.receive_batch(receive_batch, 1) == 1);
+		assert(b.receive_batch(receive_batch, 1) == 1);
+		assert(b.receive_batch(receive_batch, 1) == 0);
+	}
+
+	// Test the same seed loses and reorders the same packets.
+	{
+		int order[2][64];
+		int counts[2] = { 0, 0 };
+		for (int run = 0; run < 2; run++)
+		{
+			ga_loopback_network network(1234);
+			ga_link_conditions conditions;
+			conditions._loss = 0.25f;
+			conditions._reorder = 0.25f;
+			network.set_conditions(conditions);
+			network.set_time(start);
+			ga_loopback_transport a(&network, a_address);
+			ga_loopback_transport b(&network, b_address);
+			for (int i = 0; i < 64; i++)
+			{
+				sent._data[0] = (unsigned char)i;
+				a.send_batch(send_batch, 1);
+			}
+			network.set_time(start + std::chrono::milliseconds(conditions._reorder_delay_ms));
+			while (b.receive_batch(receive_batch, 1) == 1)
+			{
+				order[run][counts[run]++] = received._data[0];
+			}
+		}
+		assert(counts[0] == counts[1] && counts[0] > 0 && counts[0] < 64);
+		bool reordered = false;
+		for (int i = 0; i < counts[0]; i++)
+		{
+			assert(order[0][i] == order[1][i]);
+			reordered = reordered || (i > 0 && order[0][i] < order[0][i - 1]);
+		}
+		assert(reordered);
+	}
+}
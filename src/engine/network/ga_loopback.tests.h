@@ -0,0 +1,3 @@
+#pragma once
+
+void ga_loopback_unit_tests();
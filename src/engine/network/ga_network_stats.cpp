@@ -0,0 +1,196 @@
+#include "ga_network_stats.h"
+#include "math/ga_math.h"
+#include <algorithm>
+#include <cstdio>
+
+ga_rolling_stat::ga_rolling_stat()
+{
+	_next = 0;
+	_count = 0;
+}
+
+void ga_rolling_stat::add(float value)
+{
+	_samples[_next] = value;
+	_next = (_next + 1) % STATS_WINDOW;
+	_count = _count < STATS_WINDOW ? _count + 1 : STATS_WINDOW;
+}
+
+int ga_rolling_stat::get_count() const
+{
+	return _count;
+}
+
+float ga_rolling_stat::get_mean() const
+{
+	float sum = 0.0f;
+	for (int i = 0; i < _count; i++)
+	{
+		sum += _samples[i];
+	}
+	return _count > 0 ? sum / _count : 0.0f;
+}
+
+float ga_rolling_stat::get_min() const
+{
+	float min = 0.0f;
+	for (int i = 0; i < _count; i++)
+	{
+		min = i == 0 || _samples[i] < min ? _samples[i] : min;
+	}
+	return min;
+}
+
+float ga_rolling_stat::get_max() const
+{
+	float max = 0.0f;
+	for (int i = 0; i < _count; i++)
+	{
+		max = i == 0 || _samples[i] > max ? _samples[i] : max;
+	}
+	return max;
+}
+
+float ga_rolling_stat::get_percentile(float fraction) const
+{
+	if (_count == 0)
+	{
+		return 0.0f;
+	}
+	float sorted[STATS_WINDOW];
+	std::copy(_samples, _samples + _count, sorted);
+	int index = (int)(fraction * (_count - 1));
+	std::nth_element(sorted, sorted + index, sorted + _count);
+	return sorted[index];
+}
+
+ga_network_stats::ga_network_stats()
+{
+	_packets_sent = 0;
+	_packets_received = 0;
+	_packets_acked = 0;
+	_packets_lost = 0;
+	_bytes_sent = 0;
+	_bytes_received = 0;
+	_bytes_sent_per_second = 0.0f;
+	_bytes_received_per_second = 0.0f;
+	_smoothed_rtt_ms = 0.0f;
+	_rtt_deviation_ms = 0.0f;
+	for (int i = 0; i < ACK_HISTORY_SIZE; i++)
+	{
+		_sent[i]._pending = false;
+	}
+	_oldest = 0;
+	_next = 0;
+	_rate_start = std::chrono::high_resolution_clock::now();
+	_rate_bytes_sent = 0;
+	_rate_bytes_received = 0;
+}
+
+void ga_network_stats::on_packet_sent(uint16_t sequence, int bytes, std::chrono::high_resolution_clock::time_point time)
+{
+	if (_oldest == _next)
+	{
+		_oldest = sequence;
+	}
+	expire(sequence, time);
+	_next = sequence + 1;
+
+	sent_t& sent = _sent[sequence % ACK_HISTORY_SIZE];
+	sent._pending = true;
+	sent._sequence = sequence;
+	sent._time = time;
+	_packets_sent++;
+	_bytes_sent += bytes;
+	_rate_bytes_sent += bytes;
+	update_rates(time);
+}
+
+void ga_network_stats::on_packet_received(int bytes, std::chrono::high_resolution_clock::time_point time)
+{
+	_packets_received++;
+	_bytes_received += bytes;
+	_rate_bytes_received += bytes;
+	update_rates(time);
+}
+
+void ga_network_stats::on_packet_acked(uint16_t sequence, std::chrono::high_resolution_clock::time_point time)
+{
+	// Acks of packets already counted, or already given up on, only move time on
+	sent_t& sent = _sent[sequence % ACK_HISTORY_SIZE];
+	if (sent._pending && sent._sequence == sequence)
+	{
+		sent._pending = false;
+		float rtt = std::chrono::duration<float, std::milli>(time - sent._time).count();
+		_rtt_ms.add(rtt);
+		if (_packets_acked == 0)
+		{
+			_smoothed_rtt_ms = rtt;
+			_rtt_deviation_ms = rtt * 0.5f;
+		}
+		else
+		{
+			_rtt_deviation_ms += (ga_absf(rtt - _smoothed_rtt_ms) - _rtt_deviation_ms) * 0.25f;
+			_smoothed_rtt_ms += (rtt - _smoothed_rtt_ms) * 0.125f;
+		}
+		_packets_acked++;
+		_loss.add(0.0f);
+	}
+	expire(_next - 1, time);
+}
+
+void ga_network_stats::expire(uint16_t newest, std::chrono::high_resolution_clock::time_point time)
+{
+	// Give up on packets unacked for too long, and on any whose slot is
+	// about to be reused by newest
+	float timeout = get_rtt_timeout_ms();
+	timeout = timeout > STATS_MIN_LOSS_TIMEOUT_MS ? timeout : STATS_MIN_LOSS_TIMEOUT_MS;
+	for (; _oldest != _next; _oldest++)
+	{
+		sent_t& sent = _sent[_oldest % ACK_HISTORY_SIZE];
+		if (!sent._pending || sent._sequence != _oldest)
+		{
+			continue;
+		}
+		bool reused = (uint16_t)(newest - _oldest) >= ACK_HISTORY_SIZE;
+		if (!reused && std::chrono::duration<float, std::milli>(time - sent._time).count() < timeout)
+		{
+			break;
+		}
+		sent._pending = false;
+		_packets_lost++;
+		_loss.add(1.0f);
+	}
+}
+
+float ga_network_stats::get_rtt_timeout_ms() const
+{
+	return _smoothed_rtt_ms + _rtt_deviation_ms * 4.0f;
+}
+
+void ga_network_stats::update_rates(std::chrono::high_resolution_clock::time_point time)
+{
+	float elapsed = std::chrono::duration<float>(time - _rate_start).count();
+	if (elapsed < 1.0f)
+	{
+		return;
+	}
+	_bytes_sent_per_second = _rate_bytes_sent / elapsed;
+	_bytes_received_per_second = _rate_bytes_received / elapsed;
+	_rate_start = time;
+	_rate_bytes_sent = 0;
+	_rate_bytes_received = 0;
+}
+
+void ga_print_network_stats(const char* name, const ga_network_stats& stats)
+{
+	printf("%s: rtt %.1f ms (p95 %.1f), loss %.1f%%, out %.2f KB/s, in %.2f KB/s, snapshot %.0f B, %.0f us\n",
+		name,
+		stats._rtt_ms.get_mean(),
+		stats._rtt_ms.get_percentile(0.95f),
+		stats._loss.get_mean() * 100.0f,
+		stats._bytes_sent_per_second / 1024.0f,
+		stats._bytes_received_per_second / 1024.0f,
+		stats._snapshot_bytes.get_mean(),
+		stats._snapshot_us.get_mean());
+}
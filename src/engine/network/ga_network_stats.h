@@ -0,0 +1,98 @@
+#pragma once
+#include "ga_packet_header.h"
+#include <chrono>
+#include <cstdint>
+
+#define STATS_WINDOW 128
+#define STATS_MIN_LOSS_TIMEOUT_MS 250
+
+/*
+** The last STATS_WINDOW samples of some measurement.
+*/
+class ga_rolling_stat
+{
+public:
+	ga_rolling_stat();
+
+	void add(float value);
+
+	int get_count() const;
+	float get_mean() const;
+	float get_min() const;
+	float get_max() const;
+
+	// Fraction in [0, 1]; 0.5 is the median. Zero when there are no samples.
+	float get_percentile(float fraction) const;
+
+private:
+	float _samples[STATS_WINDOW];
+	int _next;
+	int _count;
+};
+
+/*
+** Traffic on one connection, as seen from this end.
+** Round trip time is measured from sending a packet to receiving the first
+** header that acks it, so includes however long the other end waits before
+** sending. Packets still unacked after the smoothed round trip plus four
+** deviations, and at least STATS_MIN_LOSS_TIMEOUT_MS, count as lost.
+** Byte rates are recomputed about once a second.
+*/
+class ga_network_stats
+{
+public:
+	ga_network_stats();
+
+	void on_packet_sent(uint16_t sequence, int bytes, std::chrono::high_resolution_clock::time_point time);
+	void on_packet_received(int bytes, std::chrono::high_resolution_clock::time_point time);
+	void on_packet_acked(uint16_t sequence, std::chrono::high_resolution_clock::time_point time);
+
+	// The smoothed round trip plus four deviations: an ack taking longer
+	// than this most likely is not coming.
+	float get_rtt_timeout_ms() const;
+
+	uint64_t _packets_sent;
+	uint64_t _packets_received;
+	uint64_t _packets_acked;
+	uint64_t _packets_lost;
+	uint64_t _bytes_sent;
+	uint64_t _bytes_received;
+	float _bytes_sent_per_second;
+	float _bytes_received_per_second;
+
+	ga_rolling_stat _rtt_ms;
+
+	// Moving averages of the round trip and its deviation from the average,
+	// weighted 1/8 and 1/4 per sample. Zero until the first ack.
+	float _smoothed_rtt_ms;
+	float _rtt_deviation_ms;
+
+	// One sample per packet: 1 if it was lost, 0 if acked, so the mean is the loss rate.
+	ga_rolling_stat _loss;
+
+	// Encoded snapshot payloads, and the time spent encoding or decoding them.
+	ga_rolling_stat _snapshot_bytes;
+	ga_rolling_stat _snapshot_us;
+
+private:
+	void update_rates(std::chrono::high_resolution_clock::time_point time);
+	void expire(uint16_t newest, std::chrono::high_resolution_clock::time_point time);
+
+	struct sent_t
+	{
+		bool _pending;
+		uint16_t _sequence;
+		std::chrono::high_resolution_clock::time_point _time;
+	};
+	sent_t _sent[ACK_HISTORY_SIZE];
+
+	// Packets are sent in sequence order, so only the oldest needs checking
+	uint16_t _oldest;
+	uint16_t _next;
+
+	std::chrono::high_resolution_clock::time_point _rate_start;
+	uint64_t _rate_bytes_sent;
+	uint64_t _rate_bytes_received;
+};
+
+void ga_print_network_stats(const char* name, const ga_network_stats& stats);
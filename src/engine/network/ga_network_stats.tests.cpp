@@ -0,0 +1,56 @@
+#include "ga_network_stats.tests.h"
+#include "ga_network_stats.h"
+
+#include "math/ga_math.h"
+
+#include <cassert>
+
+void ga_network_stats_unit_tests()
+{
+	// Test rolling stats only keep the newest window of samples.
+	{
+		ga_rolling_stat stat;
+		assert(stat.get_mean() == 0.0f && stat.get_percentile(0.5f) == 0.0f);
+		for (int i = 0; i < STATS_WINDOW + 10; i++)
+		{
+			stat.add(i < 10 ? 1000.0f : (float)(i % 4));
+		}
+		assert(stat.get_count() == STATS_WINDOW);
+		assert(stat.get_max() == 3.0f);
+		assert(stat.get_mean() == 1.5f);
+		assert(stat.get_percentile(0.0f) == 0.0f);
+		assert(stat.get_percentile(1.0f) == 3.0f);
+	}
+
+	// Test acks give round trips and packets that stay unacked count as lost.
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		ga_network_stats stats;
+		stats.on_packet_sent(0, 100, start);
+		stats.on_packet_sent(1, 100, start);
+		stats.on_packet_acked(0, start + std::chrono::milliseconds(40));
+		stats.on_packet_acked(0, start + std::chrono::milliseconds(90));
+		assert(stats._rtt_ms.get_count() == 1);
+		assert(ga_absf(stats._rtt_ms.get_mean() - 40.0f) < 0.01f);
+		assert(stats._packets_sent == 2 && stats._bytes_sent == 200);
+
+		assert(ga_absf(stats._smoothed_rtt_ms - 40.0f) < 0.01f);
+
+		auto later = start + std::chrono::milliseconds(STATS_MIN_LOSS_TIMEOUT_MS - 1);
+		stats.on_packet_sent(2, 100, later);
+		assert(stats._packets_lost == 0);
+		later = start + std::chrono::milliseconds(STATS_MIN_LOSS_TIMEOUT_MS);
+		stats.on_packet_sent(3, 100, later);
+		assert(stats._packets_lost == 1);
+		assert(stats._loss.get_count() == 2 && stats._loss.get_mean() == 0.5f);
+		stats.on_packet_acked(1, later);
+		assert(stats._rtt_ms.get_count() == 1);
+
+		// Slots reused before the timeout count as lost too
+		for (int i = 0; i < ACK_HISTORY_SIZE; i++)
+		{
+			stats.on_packet_sent((uint16_t)(4 + i), 100, later);
+		}
+		assert(stats._packets_lost == 3);
+	}
+}
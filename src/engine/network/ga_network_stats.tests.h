@@ -0,0 +1,3 @@
+#pragma once
+
+void ga_network_stats_unit_tests();
@@ -0,0 +1,144 @@
+#include "ga_network_thread.h"
+
+// How long the thread sleeps when the pool has no packets to receive into,
+// or between polls of a transport the poller cannot wait on
+static const int k_network_starved_wait_ms = 1;
+
+ga_network_thread::ga_network_thread(ga_transport* transport, ga_packet_pool* pool) :
+	_inbound(pool->get_packet_count() + 1),
+	_outbound(pool->get_packet_count() + 1)
+{
+	_transport = transport;
+	_pool = pool;
+	_spare_count = 0;
+	_listener = 0;
+	_terminate = false;
+	_poller.add_transport(transport);
+	_thread = std::thread(run, this);
+}
+
+ga_network_thread::~ga_network_thread()
+{
+	_terminate = true;
+	_poller.notify();
+	_thread.join();
+
+	void* data;
+	while (_inbound.pop(&data))
+	{
+		_pool->free(static_cast<ga_packet*>(data));
+	}
+	while (_outbound.pop(&data))
+	{
+		_pool->free(static_cast<ga_packet*>(data));
+	}
+	for (int i = 0; i < _spare_count; i++)
+	{
+		_pool->free(_spares[i]);
+	}
+}
+
+bool ga_network_thread::pop_inbound(ga_packet** packet)
+{
+	void* data;
+	if (!_inbound.pop(&data))
+	{
+		return false;
+	}
+	*packet = static_cast<ga_packet*>(data);
+	return true;
+}
+
+void ga_network_thread::push_outbound(ga_packet* packet)
+{
+	_outbound.push(packet);
+}
+
+void ga_network_thread::flush()
+{
+	_poller.notify();
+}
+
+void ga_network_thread::set_inbound_listener(ga_poller* listener)
+{
+	_listener = listener;
+}
+
+void ga_network_thread::run(ga_network_thread* self)
+{
+	while (!self->_terminate)
+	{
+		self->send_outbound();
+		int received = self->receive_inbound();
+		if (received > 0)
+		{
+			ga_poller* listener = self->_listener;
+			if (listener)
+			{
+				listener->notify();
+			}
+		}
+		else if (self->_outbound.get_count() == 0)
+		{
+			bool pollable = self->_spare_count > 0 && self->_transport->get_handle() >= 0;
+			self->_poller.wait(pollable ? -1 : k_network_starved_wait_ms);
+		}
+	}
+}
+
+void ga_network_thread::send_outbound()
+{
+	ga_packet* batch[SOCKET_BATCH_SIZE];
+	int count = 0;
+	void* data;
+	while (_outbound.pop(&data))
+	{
+		batch[count++] = static_cast<ga_packet*>(data);
+		if (count == SOCKET_BATCH_SIZE)
+		{
+			_transport->send_batch(batch, count);
+			for (int i = 0; i < count; i++)
+			{
+				_pool->free(batch[i]);
+			}
+			count = 0;
+		}
+	}
+	if (count > 0)
+	{
+		_transport->send_batch(batch, count);
+		for (int i = 0; i < count; i++)
+		{
+			_pool->free(batch[i]);
+		}
+	}
+}
+
+int ga_network_thread::receive_inbound()
+{
+	// Keep a batch of spare packets around to receive into
+	while (_spare_count < SOCKET_BATCH_SIZE)
+	{
+		ga_packet* packet = _pool->alloc();
+		if (!packet)
+		{
+			break;
+		}
+		_spares[_spare_count++] = packet;
+	}
+	if (_spare_count == 0)
+	{
+		return 0;
+	}
+	int count = _transport->receive_batch(_spares, _spare_count);
+	for (int i = 0; i < count; i++)
+	{
+		_inbound.push(_spares[i]);
+	}
+	for (int i = count; i < _spare_count; i++)
+	{
+		_spares[i - count] = _spares[i];
+	}
+	_spare_count -= count;
+	return count;
+}
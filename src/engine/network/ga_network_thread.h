@@ -0,0 +1,46 @@
+#pragma once
+#include "ga_transport.h"
+#include "ga_packet_pool.h"
+#include "ga_poller.h"
+#include "jobs/ga_queue.h"
+#include <atomic>
+#include <thread>
+
+/*
+** Owns a transport on its own thread so packet I/O is not tied to frame time.
+** Received packets are pushed onto a lock-free inbound queue for the sim
+** thread to drain; packets pushed onto the outbound queue are sent in batches.
+** Packets always come from, and are returned to, the given pool.
+** The thread sleeps in a ga_poller until the transport is readable or flush
+** is called, and can notify another poller whenever inbound packets arrive.
+*/
+class ga_network_thread
+{
+public:
+	ga_network_thread(ga_transport* transport, ga_packet_pool* pool);
+	~ga_network_thread();
+
+	bool pop_inbound(ga_packet** packet);
+	void push_outbound(ga_packet* packet);
+
+	// Wakes the thread to send everything pushed so far.
+	void flush();
+
+	void set_inbound_listener(ga_poller* listener);
+
+private:
+	static void run(ga_network_thread* self);
+	void send_outbound();
+	int receive_inbound();
+
+	ga_transport* _transport;
+	ga_packet_pool* _pool;
+	ga_queue _inbound;
+	ga_queue _outbound;
+	ga_poller _poller;
+	std::atomic<ga_poller*> _listener;
+	ga_packet* _spares[SOCKET_BATCH_SIZE];
+	int _spare_count;
+	std::atomic_bool _terminate;
+	std::thread _thread;
+};
@@ -0,0 +1,130 @@
+#include "ga_packet_header.h"
+#include "ga_bitstream.h"
+
+int ga_write_packet_header(const ga_packet_header& header, void* out)
+{
+	ga_bit_writer writer(out, PACKET_HEADER_SIZE);
+	writer.write_bits(header._sequence, 16);
+	writer.write_bits(header._ack, 16);
+	writer.write_bits(header._ack_bits, 32);
+	return PACKET_HEADER_SIZE;
+}
+
+bool ga_read_packet_header(const void* data, int size, ga_packet_header* header)
+{
+	if (size < PACKET_HEADER_SIZE)
+	{
+		return false;
+	}
+	ga_bit_reader reader(data, PACKET_HEADER_SIZE);
+	header->_sequence = reader.read_bits(16);
+	header->_ack = reader.read_bits(16);
+	header->_ack_bits = reader.read_bits(32);
+	return true;
+}
+
+bool ga_sequence_greater(uint16_t a, uint16_t b)
+{
+	return ((a > b) && (a - b <= 32768)) ||
+		((a < b) && (b - a > 32768));
+}
+
+ga_ack_tracker::ga_ack_tracker()
+{
+	_local_sequence = 0;
+	for (int i = 0; i < ACK_HISTORY_SIZE; i++)
+	{
+		_sent_sequences[i] = 0;
+		_sent_pending[i] = false;
+	}
+	// Until something arrives, ack a sequence the other end won't send for a
+	// long while, so no packet is acked by accident
+	_has_remote = false;
+	_remote_sequence = 0xffff;
+	_received_bits = 0;
+	_acked_count = 0;
+}
+
+void ga_ack_tracker::prepare_header(ga_packet_header* header)
+{
+	int slot = _local_sequence % ACK_HISTORY_SIZE;
+	_sent_sequences[slot] = _local_sequence;
+	_sent_pending[slot] = true;
+
+	header->_sequence = _local_sequence++;
+	header->_ack = _remote_sequence;
+	header->_ack_bits = _received_bits;
+}
+
+bool ga_ack_tracker::process_header(const ga_packet_header& header)
+{
+	_acked_count = 0;
+	ack_sent(header._ack);
+	for (int i = 0; i < 32; i++)
+	{
+		if (header._ack_bits & (1u << i))
+		{
+			ack_sent(header._ack - 1 - i);
+		}
+	}
+
+	uint16_t sequence = header._sequence;
+	if (!_has_remote)
+	{
+		_has_remote = true;
+		_remote_sequence = sequence;
+		_received_bits = 0;
+		return true;
+	}
+	if (ga_sequence_greater(sequence, _remote_sequence))
+	{
+		// Slide the window forward; the old newest becomes an ack bit
+		uint16_t shift = sequence - _remote_sequence;
+		if (shift > 32)
+		{
+			_received_bits = 0;
+		}
+		else if (shift == 32)
+		{
+			_received_bits = 1u << 31;
+		}
+		else
+		{
+			_received_bits = (_received_bits << shift) | (1u << (shift - 1));
+		}
+		_remote_sequence = sequence;
+		return true;
+	}
+	uint16_t age = _remote_sequence - sequence;
+	if (age == 0 || age > 32 || (_received_bits & (1u << (age - 1))))
+	{
+		return false;
+	}
+	_received_bits |= 1u << (age - 1);
+	return true;
+}
+
+int ga_ack_tracker::get_acked_count() const
+{
+	return _acked_count;
+}
+
+uint16_t ga_ack_tracker::get_acked(int index) const
+{
+	return _acked[index];
+}
+
+uint16_t ga_ack_tracker::get_local_sequence() const
+{
+	return _local_sequence;
+}
+
+void ga_ack_tracker::ack_sent(uint16_t sequence)
+{
+	int slot = sequence % ACK_HISTORY_SIZE;
+	if (_sent_pending[slot] && _sent_sequences[slot] == sequence)
+	{
+		_sent_pending[slot] = false;
+		_acked[_acked_count++] = sequence;
+	}
+}
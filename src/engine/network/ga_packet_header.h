@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+
+#define PACKET_HEADER_SIZE 8
+#define ACK_HISTORY_SIZE 256
+
+/*
+** Prefixed to every packet in both directions.
+** _ack is the newest sequence received from the other end, and bit i of
+** _ack_bits is set if sequence _ack - 1 - i was received as well.
+*/
+struct ga_packet_header
+{
+	uint16_t _sequence;
+	uint16_t _ack;
+	uint32_t _ack_bits;
+};
+
+/*
+** First byte of the body of a packet from a client.
+** A packet with an empty body only carries acks.
+*/
+enum ga_client_message_t
+{
+	k_message_connect = 1,
+	k_message_input = 2,
+};
+
+int ga_write_packet_header(const ga_packet_header& header, void* out);
+bool ga_read_packet_header(const void* data, int size, ga_packet_header* header);
+
+// True if sequence a is newer than b, allowing for wrap around.
+bool ga_sequence_greater(uint16_t a, uint16_t b);
+
+/*
+** Sequence and ack bookkeeping for one end of a connection.
+** Every header received acks the last 33 packets the other end saw, so an
+** ack only goes missing if that many packets in a row are lost.
+*/
+class ga_ack_tracker
+{
+public:
+	ga_ack_tracker();
+
+	// Assigns the next local sequence and stamps the latest acks into the header.
+	void prepare_header(ga_packet_header* header);
+
+	// Records a received header. Returns false if its packet is a duplicate or
+	// too old to track and should be dropped. The acks it carries count either way.
+	bool process_header(const ga_packet_header& header);
+
+	// Local sequences newly acked by the last processed header, each reported once.
+	int get_acked_count() const;
+	uint16_t get_acked(int index) const;
+
+	uint16_t get_local_sequence() const;
+
+private:
+	void ack_sent(uint16_t sequence);
+
+	uint16_t _local_sequence;
+	uint16_t _sent_sequences[ACK_HISTORY_SIZE];
+	bool _sent_pending[ACK_HISTORY_SIZE];
+
+	bool _has_remote;
+	uint16_t _remote_sequence;
+	uint32_t _received_bits;
+
+	uint16_t _acked[33];
+	int _acked_count;
+};
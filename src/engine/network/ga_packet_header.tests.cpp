@@ -0,0 +1,80 @@
+#include "ga_packet_header.tests.h"
+#include "ga_packet_header.h"
+
+#include <cassert>
+
+void ga_packet_header_unit_tests()
+{
+	// Test headers round trip.
+	{
+		ga_packet_header header = { 0xfffe, 1234, 0x80000001 };
+		unsigned char buffer[PACKET_HEADER_SIZE];
+		assert(ga_write_packet_header(header, buffer) == PACKET_HEADER_SIZE);
+
+		ga_packet_header read;
+		assert(ga_read_packet_header(buffer, sizeof(buffer), &read));
+		assert(read._sequence == 0xfffe && read._ack == 1234 && read._ack_bits == 0x80000001);
+		assert(!ga_read_packet_header(buffer, PACKET_HEADER_SIZE - 1, &read));
+	}
+
+	// Test lost packets stay unacked and every other one is acked exactly once.
+	{
+		ga_ack_tracker sender;
+		ga_ack_tracker receiver;
+		ga_packet_header sent[3];
+		for (int i = 0; i < 3; i++)
+		{
+			sender.prepare_header(&sent[i]);
+		}
+		assert(receiver.process_header(sent[0]));
+		assert(receiver.process_header(sent[2]));
+
+		ga_packet_header reply;
+		receiver.prepare_header(&reply);
+		assert(reply._ack == 2 && reply._ack_bits == 2);
+
+		sender.process_header(reply);
+		assert(sender.get_acked_count() == 2);
+		assert(sender.get_acked(0) == 2 && sender.get_acked(1) == 0);
+
+		// The late packet is still accepted, a repeat of it is not.
+		assert(receiver.process_header(sent[1]));
+		assert(!receiver.process_header(sent[1]));
+		receiver.prepare_header(&reply);
+		assert(reply._ack_bits == 3);
+		sender.process_header(reply);
+		assert(sender.get_acked_count() == 1 && sender.get_acked(0) == 1);
+	}
+
+	// Test nothing is acked before anything arrives, and old packets are dropped.
+	{
+		ga_ack_tracker a;
+		ga_ack_tracker b;
+		ga_packet_header header;
+		a.prepare_header(&header);
+		ga_packet_header empty;
+		b.prepare_header(&empty);
+		a.process_header(empty);
+		assert(a.get_acked_count() == 0);
+
+		ga_packet_header old = header;
+		for (int i = 0; i < 40; i++)
+		{
+			a.prepare_header(&header);
+		}
+		assert(b.process_header(header));
+		assert(!b.process_header(old));
+	}
+
+	// Test the window survives sequence wrap around.
+	{
+		ga_ack_tracker receiver;
+		ga_packet_header header = { 0xffff, 0, 0 };
+		assert(receiver.process_header(header));
+		header._sequence = 1;
+		assert(receiver.process_header(header));
+		ga_packet_header reply;
+		receiver.prepare_header(&reply);
+		assert(reply._ack == 1 && reply._ack_bits == 2);
+	}
+}
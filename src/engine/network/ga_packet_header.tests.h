@@ -0,0 +1,3 @@
+#pragma once
+
+void ga_packet_header_unit_tests();
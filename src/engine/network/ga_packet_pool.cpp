@@ -0,0 +1,93 @@
+#include "ga_packet_pool.h"
+
+ga_packet_pool::ga_packet_pool(int packet_count) : _indices(packet_count)
+{
+	_available = packet_count;
+	_packets = new ga_packet[packet_count];
+}
+
+ga_packet_pool::~ga_packet_pool()
+{
+	delete[] _packets;
+}
+
+ga_packet* ga_packet_pool::alloc()
+{
+	// ga_intpool spins when empty, so reserve a packet before taking an index
+	if (_available.fetch_sub(1) <= 0)
+	{
+		_available.fetch_add(1);
+		return 0;
+	}
+	ga_packet* packet = &_packets[_indices.alloc()];
+	packet->_size = 0;
+	return packet;
+}
+
+void ga_packet_pool::free(ga_packet* packet)
+{
+	_indices.free(int(packet - _packets));
+	_available.fetch_add(1);
+}
+
+int ga_packet_pool::get_packet_count() const
+{
+	return _indices.get_index_count();
+}
+
+int ga_packet_pool::get_available_count() const
+{
+	return _available;
+}
+
+ga_packet_ref::ga_packet_ref(ga_packet_pool* pool)
+{
+	_pool = pool;
+	_packet = pool->alloc();
+}
+
+ga_packet_ref::ga_packet_ref(ga_packet_pool* pool, ga_packet* packet)
+{
+	_pool = pool;
+	_packet = packet;
+}
+
+ga_packet_ref::ga_packet_ref(ga_packet_ref&& other)
+{
+	_pool = other._pool;
+	_packet = other._packet;
+	other._packet = 0;
+}
+
+ga_packet_ref::~ga_packet_ref()
+{
+	reset();
+}
+
+ga_packet_ref& ga_packet_ref::operator=(ga_packet_ref&& other)
+{
+	if (&other != this)
+	{
+		reset();
+		_pool = other._pool;
+		_packet = other._packet;
+		other._packet = 0;
+	}
+	return *this;
+}
+
+void ga_packet_ref::reset()
+{
+	if (_packet)
+	{
+		_pool->free(_packet);
+		_packet = 0;
+	}
+}
+
+ga_packet* ga_packet_ref::release()
+{
+	ga_packet* packet = _packet;
+	_packet = 0;
+	return packet;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "ga_socket.h"
+#include "jobs/ga_intpool.h"
+#include <atomic>
+
+/*
+** A fixed-capacity, thread-safe and lock-free pool of packet buffers.
+** Built on the ga_intpool free-list; never touches the heap after construction.
+*/
+class ga_packet_pool
+{
+public:
+	ga_packet_pool(int packet_count);
+	~ga_packet_pool();
+
+	// Returns NULL when every packet is in use.
+	ga_packet* alloc();
+	void free(ga_packet* packet);
+
+	int get_packet_count() const;
+	int get_available_count() const;
+
+private:
+	ga_intpool _indices;
+	std::atomic_int _available;
+	ga_packet* _packets;
+};
+
+/*
+** Owns one packet from a pool and returns it to the pool when destroyed.
+*/
+class ga_packet_ref
+{
+public:
+	ga_packet_ref() : _pool(0), _packet(0) {}
+	ga_packet_ref(ga_packet_pool* pool);
+	ga_packet_ref(ga_packet_pool* pool, ga_packet* packet);
+	ga_packet_ref(ga_packet_ref&& other);
+	~ga_packet_ref();
+
+	ga_packet_ref& operator=(ga_packet_ref&& other);
+
+	ga_packet* get() const { return _packet; }
+	ga_packet* operator->() const { return _packet; }
+	explicit operator bool() const { return _packet != 0; }
+
+	void reset();
+
+	// Gives up ownership, e.g. to pass the packet to another thread through a queue.
+	ga_packet* release();
+
+private:
+	ga_packet_ref(const ga_packet_ref&) = delete;
+	ga_packet_ref& operator=(const ga_packet_ref&) = delete;
+
+	ga_packet_pool* _pool;
+	ga_packet* _packet;
+};
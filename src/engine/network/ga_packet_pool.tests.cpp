@@ -0,0 +1,25 @@
+#include "ga_packet_pool.tests.h"
+#include "ga_packet_pool.h"
+
+#include <cassert>
+#include <utility>
+
+void ga_packet_pool_unit_tests()
+{
+	// Test the pool runs dry without blocking and handles give packets back.
+	{
+		ga_packet_pool pool(2);
+		{
+			ga_packet_ref a(&pool);
+			ga_packet_ref b(&pool);
+			ga_packet_ref c(&pool);
+			assert(a && b && !c);
+			assert(a.get() != b.get());
+			assert(pool.get_available_count() == 0);
+
+			ga_packet_ref moved = std::move(a);
+			assert(!a && moved);
+		}
+		assert(pool.get_available_count() == 2);
+	}
+}
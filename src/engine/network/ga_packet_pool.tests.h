@@ -0,0 +1,3 @@
+#pragma once
+
+void ga_packet_pool_unit_tests();
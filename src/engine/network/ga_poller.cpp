@@ -0,0 +1,186 @@
+#include "ga_poller.h"
+
+#if defined(GA_POLLER_EPOLL)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+enum ga_poller_source_t
+{
+	k_source_socket,
+	k_source_timer,
+	k_source_event,
+};
+
+ga_poller::ga_poller()
+{
+	_transport = 0;
+	_tick_interval = std::chrono::microseconds(0);
+	_epoll = epoll_create1(0);
+	_timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+	_event = eventfd(0, EFD_NONBLOCK);
+
+	epoll_event ev = {};
+	ev.events = EPOLLIN;
+	ev.data.u32 = k_source_timer;
+	epoll_ctl(_epoll, EPOLL_CTL_ADD, _timer, &ev);
+	ev.data.u32 = k_source_event;
+	epoll_ctl(_epoll, EPOLL_CTL_ADD, _event, &ev);
+}
+
+ga_poller::~ga_poller()
+{
+	close(_event);
+	close(_timer);
+	close(_epoll);
+}
+
+void ga_poller::add_transport(ga_transport* transport)
+{
+	_transport = transport;
+	if (transport->get_handle() < 0)
+	{
+		return;
+	}
+	epoll_event ev = {};
+	ev.events = EPOLLIN;
+	ev.data.u32 = k_source_socket;
+	epoll_ctl(_epoll, EPOLL_CTL_ADD, transport->get_handle(), &ev);
+}
+
+void ga_poller::set_tick_interval(std::chrono::microseconds interval)
+{
+	_tick_interval = interval;
+	itimerspec spec = {};
+	spec.it_interval.tv_sec = interval.count() / 1000000;
+	spec.it_interval.tv_nsec = (interval.count() % 1000000) * 1000;
+	spec.it_value = spec.it_interval;
+	timerfd_settime(_timer, 0, &spec, NULL);
+}
+
+void ga_poller::notify()
+{
+	uint64_t one = 1;
+	ssize_t written = write(_event, &one, sizeof(one));
+	(void)written;
+}
+
+int ga_poller::wait(int timeout_ms)
+{
+	epoll_event events[3];
+	int count = epoll_wait(_epoll, events, 3, timeout_ms);
+	int result = 0;
+	for (int i = 0; i < count; i++)
+	{
+		uint64_t value;
+		switch (events[i].data.u32)
+		{
+		case k_source_socket:
+			result |= k_poll_readable;
+			break;
+		case k_source_timer:
+			// Drain the expiration count; missed ticks collapse into one
+			if (read(_timer, &value, sizeof(value)) > 0)
+			{
+				result |= k_poll_tick;
+			}
+			break;
+		case k_source_event:
+			if (read(_event, &value, sizeof(value)) > 0)
+			{
+				result |= k_poll_notified;
+			}
+			break;
+		}
+	}
+	return result;
+}
+
+#else
+
+// Transports are checked at this granularity so notify is still seen promptly
+static const int k_poller_slice_ms = 1;
+
+ga_poller::ga_poller()
+{
+	_transport = 0;
+	_tick_interval = std::chrono::microseconds(0);
+	_notified = false;
+}
+
+ga_poller::~ga_poller()
+{
+}
+
+void ga_poller::add_transport(ga_transport* transport)
+{
+	_transport = transport;
+}
+
+void ga_poller::set_tick_interval(std::chrono::microseconds interval)
+{
+	_tick_interval = interval;
+	_next_tick = std::chrono::steady_clock::now() + interval;
+}
+
+void ga_poller::notify()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_notified = true;
+	_condvar.notify_all();
+}
+
+int ga_poller::wait(int timeout_ms)
+{
+	auto now = std::chrono::steady_clock::now();
+	auto deadline = timeout_ms < 0 ? std::chrono::steady_clock::time_point::max() : now + std::chrono::milliseconds(timeout_ms);
+	if (_tick_interval.count() > 0 && _next_tick < deadline)
+	{
+		deadline = _next_tick;
+	}
+
+	int result = 0;
+	while (result == 0)
+	{
+		if (_notified.exchange(false))
+		{
+			result |= k_poll_notified;
+		}
+		now = std::chrono::steady_clock::now();
+		if (_tick_interval.count() > 0 && now >= _next_tick)
+		{
+			while (_next_tick <= now)
+			{
+				_next_tick += _tick_interval;
+			}
+			result |= k_poll_tick;
+		}
+		if (result != 0 || now >= deadline)
+		{
+			break;
+		}
+		if (_transport)
+		{
+			if (_transport->wait(k_poller_slice_ms))
+			{
+				result |= k_poll_readable;
+			}
+		}
+		else
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			if (deadline == std::chrono::steady_clock::time_point::max())
+			{
+				_condvar.wait(lock, [this]() { return _notified.load(); });
+			}
+			else
+			{
+				_condvar.wait_until(lock, deadline, [this]() { return _notified.load(); });
+			}
+		}
+	}
+	return result;
+}
+
+#endif
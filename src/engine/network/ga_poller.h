@@ -0,0 +1,57 @@
+#pragma once
+#include "ga_transport.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#if defined(__linux__)
+#define GA_POLLER_EPOLL
+#endif
+
+/*
+** Events returned by ga_poller::wait.
+*/
+enum ga_poll_event_t
+{
+	k_poll_readable = 1 << 0,
+	k_poll_tick = 1 << 1,
+	k_poll_notified = 1 << 2,
+};
+
+/*
+** Sleeps until a transport is readable, a periodic tick is due, or another
+** thread calls notify. On Linux this is an epoll set holding the socket,
+** a timerfd and an eventfd; elsewhere it falls back to select and a
+** condition variable. Transports without a handle are not waited on
+** under epoll, so their users must poll them.
+*/
+class ga_poller
+{
+public:
+	ga_poller();
+	~ga_poller();
+
+	void add_transport(ga_transport* transport);
+	void set_tick_interval(std::chrono::microseconds interval);
+
+	// Thread-safe; wakes a wait in progress or the next one.
+	void notify();
+
+	// Returns a mask of ga_poll_event_t, or 0 on timeout. Negative timeout waits forever.
+	int wait(int timeout_ms);
+
+private:
+	ga_transport* _transport;
+	std::chrono::microseconds _tick_interval;
+#if defined(GA_POLLER_EPOLL)
+	int _epoll;
+	int _timer;
+	int _event;
+#else
+	std::chrono::steady_clock::time_point _next_tick;
+	std::atomic_bool _notified;
+	std::condition_variable _condvar;
+	std::mutex _mutex;
+#endif
+};
@@ -0,0 +1,80 @@
+#include "ga_quantize.h"
+#include "math/ga_math.h"
+
+static const float k_smallest_three_range = 0.70710678f;
+
+int ga_quantization::get_axis_bits(int axis) const
+{
+	uint32_t max_value = ga_quantize_float(_world_max.axes[axis], _world_min.axes[axis], _world_max.axes[axis], _precision.axes[axis]);
+	int bits = 1;
+	while (bits < 32 && (max_value >> bits) != 0)
+	{
+		bits++;
+	}
+	return bits;
+}
+
+uint32_t ga_quantize_float(float value, float min, float max, float precision)
+{
+	value = ga_min(ga_max(value, min), max);
+	return (uint32_t)((value - min) / precision + 0.5f);
+}
+
+float ga_dequantize_float(uint32_t value, float min, float precision)
+{
+	return min + value * precision;
+}
+
+uint32_t ga_quantize_quat(const ga_quatf& q, int bits)
+{
+	// Find the largest component; q and -q are the same rotation so flip it positive
+	uint32_t largest = 0;
+	for (uint32_t i = 1; i < 4; i++)
+	{
+		if (ga_absf(q.axes[i]) > ga_absf(q.axes[largest]))
+		{
+			largest = i;
+		}
+	}
+	float sign = q.axes[largest] < 0.0f ? -1.0f : 1.0f;
+
+	// Use an odd number of steps so that zero is exactly representable
+	uint32_t max_value = (1u << bits) - 2;
+	float step = 2.0f * k_smallest_three_range / max_value;
+	uint32_t packed = largest;
+	int shift = 2;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		if (i == largest)
+		{
+			continue;
+		}
+		uint32_t component = ga_quantize_float(q.axes[i] * sign, -k_smallest_three_range, k_smallest_three_range, step);
+		packed |= ga_min(component, max_value) << shift;
+		shift += bits;
+	}
+	return packed;
+}
+
+ga_quatf ga_dequantize_quat(uint32_t packed, int bits)
+{
+	uint32_t largest = packed & 3;
+	uint32_t mask = (1u << bits) - 1;
+	float step = 2.0f * k_smallest_three_range / (mask - 1);
+
+	ga_quatf q;
+	float sum = 0.0f;
+	int shift = 2;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		if (i == largest)
+		{
+			continue;
+		}
+		q.axes[i] = ga_dequantize_float((packed >> shift) & mask, -k_smallest_three_range, step);
+		sum += q.axes[i] * q.axes[i];
+		shift += bits;
+	}
+	q.axes[largest] = ga_sqrtf(ga_max(0.0f, 1.0f - sum));
+	return q;
+}
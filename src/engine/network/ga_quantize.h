@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include "math/ga_quatf.h"
+#include "math/ga_vec3f.h"
+
+/*
+** Bounds and precision used to turn snapshot state into integers before it
+** is diffed. Positions outside the world bounds are clamped. Server and
+** client must agree on these values.
+*/
+struct ga_quantization
+{
+	ga_vec3f _world_min = { -256.0f, -64.0f, -256.0f };
+	ga_vec3f _world_max = { 256.0f, 192.0f, 256.0f };
+
+	// Smallest representable step per position axis, in world units.
+	ga_vec3f _precision = { 1.0f / 1024.0f, 1.0f / 1024.0f, 1.0f / 1024.0f };
+
+	// Changes that fit in this many bits are sent as a delta from the baseline.
+	int _delta_bits = 10;
+
+	// Bits per smallest-three quaternion component, at most 10.
+	int _rotation_bits = 10;
+
+	int get_axis_bits(int axis) const;
+};
+
+uint32_t ga_quantize_float(float value, float min, float max, float precision);
+float ga_dequantize_float(uint32_t value, float min, float precision);
+
+/*
+** Smallest-three quaternion encoding.
+** Drops the largest component (recomputed from the unit length on decode)
+** and packs its index plus the other three components into one integer.
+*/
+uint32_t ga_quantize_quat(const ga_quatf& q, int bits);
+ga_quatf ga_dequantize_quat(uint32_t packed, int bits);
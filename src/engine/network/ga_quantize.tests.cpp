@@ -0,0 +1,35 @@
+#include "ga_quantize.tests.h"
+#include "ga_quantize.h"
+
+#include <cassert>
+
+void ga_quantize_unit_tests()
+{
+	// Test positions snap to the configured precision and clamp to the world bounds.
+	{
+		uint32_t q = ga_quantize_float(1.25f, -256.0f, 256.0f, 0.25f);
+		assert(ga_equalf(ga_dequantize_float(q, -256.0f, 0.25f), 1.25f));
+		q = ga_quantize_float(1.3f, -256.0f, 256.0f, 0.25f);
+		assert(ga_equalf(ga_dequantize_float(q, -256.0f, 0.25f), 1.25f));
+		q = ga_quantize_float(1000.0f, -256.0f, 256.0f, 0.25f);
+		assert(ga_equalf(ga_dequantize_float(q, -256.0f, 0.25f), 256.0f));
+
+		ga_quantization quantization;
+		assert(quantization.get_axis_bits(0) == 20);
+	}
+
+	// Test smallest-three quaternions round trip.
+	{
+		ga_quatf identity;
+		identity.make_axis_angle(ga_vec3f::y_vector(), 0.0f);
+		ga_quatf result = ga_dequantize_quat(ga_quantize_quat(identity, 10), 10);
+		assert(ga_absf(result.x) < 0.0001f && ga_absf(result.y) < 0.0001f && ga_absf(result.z) < 0.0001f);
+		assert(ga_absf(result.w - 1.0f) < 0.0001f);
+
+		ga_quatf rotation;
+		rotation.make_axis_angle(ga_vec3f::z_vector(), ga_degrees_to_radians(-120.0f));
+		result = ga_dequantize_quat(ga_quantize_quat(rotation, 10), 10);
+		float dot = ga_absf(result.v4.dot(rotation.v4));
+		assert(dot > 0.9999f);
+	}
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void ga_quantize_unit_tests();
@@ -0,0 +1,193 @@
+#include "ga_reliable_channel.h"
+#include "ga_bitstream.h"
+
+ga_reliable_channel::ga_reliable_channel()
+{
+	for (int i = 0; i < RELIABLE_WINDOW; i++)
+	{
+		_sent[i]._used = false;
+		_received[i]._used = false;
+	}
+	for (int i = 0; i < ACK_HISTORY_SIZE; i++)
+	{
+		_packets[i]._used = false;
+	}
+	_next_send = 0;
+	_oldest_unacked = 0;
+	_next_receive = 0;
+}
+
+bool ga_reliable_channel::send(const void* data, int size)
+{
+	if (size < 0 || size > RELIABLE_MAX_MESSAGE || (uint16_t)(_next_send - _oldest_unacked) >= RELIABLE_WINDOW)
+	{
+		return false;
+	}
+	message_t& message = _sent[_next_send % RELIABLE_WINDOW];
+	message._used = true;
+	message._sent = false;
+	message._id = _next_send++;
+	message._data.assign((const uint8_t*)data, (const uint8_t*)data + size);
+	return true;
+}
+
+int ga_reliable_channel::write(uint16_t packet_sequence, std::chrono::high_resolution_clock::time_point time, float resend_ms, void* out, int capacity)
+{
+	// Oldest first, skipping any that do not fit so smaller ones still can
+	packet_t& packet = _packets[packet_sequence % ACK_HISTORY_SIZE];
+	packet._used = false;
+	packet._sequence = packet_sequence;
+	packet._count = 0;
+	int remaining = (capacity - RELIABLE_HEADER_SIZE) * 8;
+	for (uint16_t id = _oldest_unacked; id != _next_send && packet._count < RELIABLE_MAX_PER_PACKET; id++)
+	{
+		const message_t& message = _sent[id % RELIABLE_WINDOW];
+		int bits = get_message_bits((int)message._data.size());
+		if (is_due(message, time, resend_ms) && bits <= remaining)
+		{
+			remaining -= bits;
+			packet._ids[packet._count++] = id;
+		}
+	}
+
+	ga_bit_writer writer(out, capacity);
+	writer.write_bits(packet._count, 8);
+	for (int i = 0; i < packet._count; i++)
+	{
+		message_t& message = _sent[packet._ids[i] % RELIABLE_WINDOW];
+		message._sent = true;
+		message._last_sent = time;
+		writer.write_bits(message._id, 16);
+		writer.write_varint((uint32_t)message._data.size());
+		for (size_t b = 0; b < message._data.size(); b++)
+		{
+			writer.write_bits(message._data[b], 8);
+		}
+	}
+	packet._used = packet._count > 0;
+	return writer.get_bytes_written();
+}
+
+bool ga_reliable_channel::has_due(std::chrono::high_resolution_clock::time_point time, float resend_ms) const
+{
+	for (uint16_t id = _oldest_unacked; id != _next_send; id++)
+	{
+		if (is_due(_sent[id % RELIABLE_WINDOW], time, resend_ms))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void ga_reliable_channel::on_packet_acked(uint16_t packet_sequence)
+{
+	packet_t& packet = _packets[packet_sequence % ACK_HISTORY_SIZE];
+	if (!packet._used || packet._sequence != packet_sequence)
+	{
+		return;
+	}
+	packet._used = false;
+	for (int i = 0; i < packet._count; i++)
+	{
+		message_t& message = _sent[packet._ids[i] % RELIABLE_WINDOW];
+		if (message._used && message._id == packet._ids[i])
+		{
+			message._used = false;
+		}
+	}
+	while (_oldest_unacked != _next_send && !_sent[_oldest_unacked % RELIABLE_WINDOW]._used)
+	{
+		_oldest_unacked++;
+	}
+}
+
+int ga_reliable_channel::read(const void* data, int size)
+{
+	ga_bit_reader reader(data, size);
+	int count = reader.read_bits(8);
+	for (int i = 0; i < count; i++)
+	{
+		uint16_t id = reader.read_bits(16);
+		uint32_t length = reader.read_varint();
+		if (reader.overflowed() || length > RELIABLE_MAX_MESSAGE || length * 8 > (uint32_t)reader.get_bits_remaining())
+		{
+			return -1;
+		}
+		// Resends of messages already delivered or already waiting are skipped
+		message_t& message = _received[id % RELIABLE_WINDOW];
+		bool wanted = (uint16_t)(id - _next_receive) < RELIABLE_WINDOW && !(message._used && message._id == id);
+		if (wanted)
+		{
+			message._used = true;
+			message._id = id;
+			message._data.resize(length);
+		}
+		for (uint32_t b = 0; b < length; b++)
+		{
+			uint8_t value = (uint8_t)reader.read_bits(8);
+			if (wanted)
+			{
+				message._data[b] = value;
+			}
+		}
+	}
+	return reader.overflowed() ? -1 : (reader.get_bits_read() + 7) / 8;
+}
+
+bool ga_reliable_channel::receive(std::vector<uint8_t>* message)
+{
+	message_t& next = _received[_next_receive % RELIABLE_WINDOW];
+	if (!next._used || next._id != _next_receive)
+	{
+		return false;
+	}
+	next._used = false;
+	message->swap(next._data);
+	_next_receive++;
+	return true;
+}
+
+int ga_reliable_channel::get_block_size(const void* data, int size)
+{
+	ga_bit_reader reader(data, size);
+	int count = reader.read_bits(8);
+	for (int i = 0; i < count; i++)
+	{
+		reader.read_bits(16);
+		uint32_t length = reader.read_varint();
+		if (reader.overflowed() || length > RELIABLE_MAX_MESSAGE || length * 8 > (uint32_t)reader.get_bits_remaining())
+		{
+			return -1;
+		}
+		for (uint32_t b = 0; b < length; b++)
+		{
+			reader.read_bits(8);
+		}
+	}
+	return reader.overflowed() ? -1 : (reader.get_bits_read() + 7) / 8;
+}
+
+bool ga_reliable_channel::is_due(const message_t& message, std::chrono::high_resolution_clock::time_point time, float resend_ms) const
+{
+	if (!message._used)
+	{
+		return false;
+	}
+	if (!message._sent)
+	{
+		return true;
+	}
+	float delay = resend_ms > RELIABLE_MIN_RESEND_MS ? resend_ms : RELIABLE_MIN_RESEND_MS;
+	return std::chrono::duration<float, std::milli>(time - message._last_sent).count() >= delay;
+}
+
+int ga_reliable_channel::get_message_bits(int size)
+{
+	int varint_bits = 8;
+	for (int n = size >> 7; n != 0; n >>= 7)
+	{
+		varint_bits += 8;
+	}
+	return 16 + varint_bits + size * 8;
+}
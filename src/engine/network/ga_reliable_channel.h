@@ -0,0 +1,77 @@
+#pragma once
+#include "ga_packet_header.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#define RELIABLE_HEADER_SIZE 1
+#define RELIABLE_WINDOW 64
+#define RELIABLE_MAX_MESSAGE 512
+#define RELIABLE_MAX_PER_PACKET 32
+#define RELIABLE_MIN_RESEND_MS 100
+
+/*
+** Messages delivered exactly once and in order over one connection.
+** Every packet carries a block of messages after its fixed header, at least
+** RELIABLE_HEADER_SIZE bytes:
+** [8 bit count] then per message [16 bit id][varint size][bytes].
+** Messages go out in whatever room a packet has left. One is sent again
+** if no packet carrying it has been acked within the resend delay, and is
+** dropped from the queue once one is. At most RELIABLE_WINDOW messages can
+** be waiting for an ack.
+*/
+class ga_reliable_channel
+{
+public:
+	ga_reliable_channel();
+
+	// Queues a message. False if it is too large or the window is full.
+	bool send(const void* data, int size);
+
+	// Writes the messages due to go out in the packet with this sequence,
+	// within capacity bytes. Returns the size of the block.
+	int write(uint16_t packet_sequence, std::chrono::high_resolution_clock::time_point time, float resend_ms, void* out, int capacity);
+
+	// True if some message would be written now.
+	bool has_due(std::chrono::high_resolution_clock::time_point time, float resend_ms) const;
+
+	void on_packet_acked(uint16_t packet_sequence);
+
+	// Reads a received block. Returns its size, or -1 if it is malformed.
+	int read(const void* data, int size);
+
+	// Pops the next message in order, if it has arrived.
+	bool receive(std::vector<uint8_t>* message);
+
+	// Size of the block at the start of data, without reading it. -1 if malformed.
+	static int get_block_size(const void* data, int size);
+
+private:
+	struct message_t
+	{
+		bool _used;
+		bool _sent;
+		uint16_t _id;
+		std::chrono::high_resolution_clock::time_point _last_sent;
+		std::vector<uint8_t> _data;
+	};
+
+	struct packet_t
+	{
+		bool _used;
+		uint16_t _sequence;
+		int _count;
+		uint16_t _ids[RELIABLE_MAX_PER_PACKET];
+	};
+
+	bool is_due(const message_t& message, std::chrono::high_resolution_clock::time_point time, float resend_ms) const;
+	static int get_message_bits(int size);
+
+	message_t _sent[RELIABLE_WINDOW];
+	uint16_t _next_send;
+	uint16_t _oldest_unacked;
+	packet_t _packets[ACK_HISTORY_SIZE];
+
+	message_t _received[RELIABLE_WINDOW];
+	uint16_t _next_receive;
+};
@@ -0,0 +1,81 @@
+#include "ga_reliable_channel.tests.h"
+#include "ga_reliable_channel.h"
+
+#include <cassert>
+#include <vector>
+
+void ga_reliable_channel_unit_tests()
+{
+	auto time = std::chrono::high_resolution_clock::now();
+	auto resend = std::chrono::milliseconds(RELIABLE_MIN_RESEND_MS);
+	uint8_t packet[64];
+	std::vector<uint8_t> message;
+
+	// Test messages are delivered in order once, across lost packets and resends.
+	{
+		ga_reliable_channel sender;
+		ga_reliable_channel receiver;
+		for (uint8_t i = 0; i < 3; i++)
+		{
+			uint8_t data[2] = { i, (uint8_t)(i * 2) };
+			assert(sender.send(data, sizeof(data)));
+		}
+
+		// The first packet only has room for two messages and is lost
+		int size = sender.write(0, time, 0.0f, packet, RELIABLE_HEADER_SIZE + 2 * 5);
+		assert(size == RELIABLE_HEADER_SIZE + 2 * 5);
+		assert(sender.has_due(time, 0.0f));
+		size = sender.write(1, time, 0.0f, packet, sizeof(packet));
+		assert(!sender.has_due(time, 0.0f));
+		assert(receiver.read(packet, size) == size);
+		assert(!receiver.receive(&message));
+
+		// Resent once the delay is up, and repeats are ignored
+		time += resend;
+		size = sender.write(2, time, 0.0f, packet, sizeof(packet));
+		assert(size == RELIABLE_HEADER_SIZE + 3 * 5);
+		assert(receiver.read(packet, size) == size);
+		assert(receiver.read(packet, size) == size);
+		for (uint8_t i = 0; i < 3; i++)
+		{
+			assert(receiver.receive(&message));
+			assert(message.size() == 2 && message[0] == i && message[1] == i * 2);
+		}
+		assert(!receiver.receive(&message));
+
+		// Acked messages are never sent again
+		sender.on_packet_acked(2);
+		time += resend;
+		assert(!sender.has_due(time, 0.0f));
+		assert(sender.write(3, time, 0.0f, packet, sizeof(packet)) == RELIABLE_HEADER_SIZE);
+		assert(ga_reliable_channel::get_block_size(packet, RELIABLE_HEADER_SIZE) == RELIABLE_HEADER_SIZE);
+	}
+
+	// Test the window fills up until the oldest message is acked.
+	{
+		ga_reliable_channel sender;
+		uint8_t data = 7;
+		for (int i = 0; i < RELIABLE_WINDOW; i++)
+		{
+			assert(sender.send(&data, 1));
+		}
+		assert(!sender.send(&data, 1));
+		assert(!sender.send(packet, RELIABLE_MAX_MESSAGE + 1));
+		sender.write(0, time, 0.0f, packet, RELIABLE_HEADER_SIZE + 4);
+		sender.on_packet_acked(0);
+		assert(sender.send(&data, 1));
+		assert(!sender.send(&data, 1));
+	}
+
+	// Test truncated blocks are rejected.
+	{
+		ga_reliable_channel sender;
+		ga_reliable_channel receiver;
+		uint8_t data[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+		sender.send(data, sizeof(data));
+		int size = sender.write(0, time, 0.0f, packet, sizeof(packet));
+		assert(ga_reliable_channel::get_block_size(packet, size - 1) == -1);
+		assert(receiver.read(packet, size - 1) == -1);
+		assert(ga_reliable_channel::get_block_size(packet, 0) == -1);
+	}
+}
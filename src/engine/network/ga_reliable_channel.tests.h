@@ -0,0 +1,3 @@
+#pragma once
+
+void ga_reliable_channel_unit_tests();
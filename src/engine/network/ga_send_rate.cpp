@@ -0,0 +1,105 @@
+#include "ga_send_rate.h"
+
+ga_send_rate::ga_send_rate()
+{
+	_interval = 1;
+	_ticks = 0;
+	_budget_scale = 1.0f;
+	_clear_periods = 0;
+	_backed_off = false;
+	_started = false;
+	_period_acked = 0;
+	_period_lost = 0;
+	_loss = 0.0f;
+}
+
+void ga_send_rate::update(const ga_network_stats& stats, std::chrono::high_resolution_clock::time_point time)
+{
+	if (!_started)
+	{
+		_started = true;
+		_period_start = time;
+		return;
+	}
+	if (time - _period_start < std::chrono::milliseconds(RATE_PERIOD_MS))
+	{
+		return;
+	}
+
+	// Too few packets settled to tell loss from chance, keep counting
+	uint64_t lost = stats._packets_lost - _period_lost;
+	uint64_t settled = stats._packets_acked - _period_acked + lost;
+	bool queueing = is_queueing(stats);
+	if (!queueing && settled < RATE_MIN_SETTLED)
+	{
+		return;
+	}
+	_period_start = time;
+	if (settled >= RATE_MIN_SETTLED)
+	{
+		_period_acked = stats._packets_acked;
+		_period_lost = stats._packets_lost;
+		if (!_backed_off)
+		{
+			_loss += RATE_LOSS_GAIN * ((float)lost / settled - _loss);
+		}
+	}
+	if (_backed_off)
+	{
+		_backed_off = false;
+		return;
+	}
+
+	bool congested = queueing || _loss > RATE_LOSS_THRESHOLD;
+	if (congested)
+	{
+		_clear_periods = 0;
+		_backed_off = true;
+		_loss = 0.0f;
+		if (_interval < MAX_SEND_INTERVAL)
+		{
+			_interval = _interval * 2 < MAX_SEND_INTERVAL ? _interval * 2 : MAX_SEND_INTERVAL;
+		}
+		else
+		{
+			_budget_scale = _budget_scale * 0.5f > MIN_BUDGET_SCALE ? _budget_scale * 0.5f : MIN_BUDGET_SCALE;
+		}
+	}
+	else if (++_clear_periods >= RATE_RECOVERY_PERIODS)
+	{
+		_clear_periods = 0;
+		if (_budget_scale < 1.0f)
+		{
+			_budget_scale = _budget_scale * 2.0f < 1.0f ? _budget_scale * 2.0f : 1.0f;
+		}
+		else if (_interval > 1)
+		{
+			_interval--;
+		}
+	}
+}
+
+bool ga_send_rate::is_queueing(const ga_network_stats& stats) const
+{
+	return stats._rtt_ms.get_count() > 0 && stats._smoothed_rtt_ms - stats._rtt_ms.get_min() > RATE_QUEUE_THRESHOLD_MS;
+}
+
+bool ga_send_rate::tick()
+{
+	if (++_ticks < _interval)
+	{
+		return false;
+	}
+	_ticks = 0;
+	return true;
+}
+
+int ga_send_rate::get_send_interval() const
+{
+	return _interval;
+}
+
+float ga_send_rate::get_budget_scale() const
+{
+	return _budget_scale;
+}
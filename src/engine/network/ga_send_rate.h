@@ -0,0 +1,55 @@
+#pragma once
+#include "ga_network_stats.h"
+
+#define MAX_SEND_INTERVAL 4
+#define MIN_BUDGET_SCALE (1.0f / 16.0f)
+#define RATE_PERIOD_MS 250
+#define RATE_MIN_SETTLED 32
+#define RATE_RECOVERY_PERIODS 4
+#define RATE_LOSS_GAIN 0.25f
+#define RATE_LOSS_THRESHOLD 0.1f
+#define RATE_QUEUE_THRESHOLD_MS 100.0f
+
+/*
+** How often, and how much, to send one connection.
+** Every RATE_PERIOD_MS the link is judged congested if its smoothed loss
+** is over RATE_LOSS_THRESHOLD, or if the smoothed round trip is
+** RATE_QUEUE_THRESHOLD_MS over the lowest recent one, meaning packets are
+** queueing somewhere on the way. Loss is only sampled once at least
+** RATE_MIN_SETTLED packets were acked or lost since the last sample, however
+** long that takes at the current rate, and moves RATE_LOSS_GAIN of the way
+** toward each sample, so chance losses on a slow link do not read as
+** congestion.
+** Congestion doubles the ticks between sends, up to MAX_SEND_INTERVAL, and
+** after that halves the snapshot budget, down to MIN_BUDGET_SCALE. Backing
+** off starts the loss estimate over, and the period after it is not judged,
+** its losses were already in flight. RATE_RECOVERY_PERIODS clear periods in a row undo one step, the
+** budget first.
+*/
+class ga_send_rate
+{
+public:
+	ga_send_rate();
+
+	void update(const ga_network_stats& stats, std::chrono::high_resolution_clock::time_point time);
+
+	// Called once per tick. True if a snapshot is due this tick.
+	bool tick();
+
+	int get_send_interval() const;
+	float get_budget_scale() const;
+
+private:
+	bool is_queueing(const ga_network_stats& stats) const;
+
+	int _interval;
+	int _ticks;
+	float _budget_scale;
+	int _clear_periods;
+	bool _backed_off;
+	bool _started;
+	std::chrono::high_resolution_clock::time_point _period_start;
+	uint64_t _period_acked;
+	uint64_t _period_lost;
+	float _loss;
+};
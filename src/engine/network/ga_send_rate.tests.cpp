@@ -0,0 +1,101 @@
+#include "ga_send_rate.tests.h"
+#include "ga_send_rate.h"
+
+#include <cassert>
+
+void ga_send_rate_unit_tests()
+{
+	auto time = std::chrono::high_resolution_clock::now();
+	auto period = std::chrono::milliseconds(RATE_PERIOD_MS);
+	ga_network_stats stats;
+	ga_send_rate rate;
+	uint16_t sequence = 0;
+
+	// Sends a period's worth of packets, acking all but lost of them after rtt_ms.
+	auto run_period = [&](int lost, int rtt_ms)
+	{
+		for (int i = 0; i < 2 * RATE_MIN_SETTLED; i++)
+		{
+			stats.on_packet_sent(sequence, 100, time);
+			if (i >= lost)
+			{
+				stats.on_packet_acked(sequence, time + std::chrono::milliseconds(rtt_ms));
+			}
+			sequence++;
+		}
+		time += period;
+		stats.on_packet_acked(sequence - 1, time);
+		rate.update(stats, time);
+	};
+
+	// Test a clear link is sent every tick.
+	{
+		rate.update(stats, time);
+		run_period(0, 20);
+		assert(rate.get_send_interval() == 1 && rate.get_budget_scale() == 1.0f);
+		assert(rate.tick() && rate.tick());
+	}
+
+	// Test loss backs off the interval, then the budget, skipping the period after each step.
+	{
+		run_period(RATE_MIN_SETTLED, 20);
+		assert(rate.get_send_interval() == 2);
+		run_period(RATE_MIN_SETTLED, 20);
+		assert(rate.get_send_interval() == 2);
+		run_period(RATE_MIN_SETTLED, 20);
+		assert(rate.get_send_interval() == MAX_SEND_INTERVAL);
+		assert(!rate.tick() || !rate.tick());
+		run_period(RATE_MIN_SETTLED, 20);
+		run_period(RATE_MIN_SETTLED, 20);
+		assert(rate.get_send_interval() == MAX_SEND_INTERVAL && rate.get_budget_scale() == 0.5f);
+	}
+
+	// Test a recovered link gets the budget back first, then the rate.
+	{
+		for (int i = 0; i < 1 + RATE_RECOVERY_PERIODS; i++)
+		{
+			run_period(0, 20);
+		}
+		assert(rate.get_budget_scale() == 1.0f && rate.get_send_interval() == MAX_SEND_INTERVAL);
+		for (int i = 0; i < RATE_RECOVERY_PERIODS; i++)
+		{
+			run_period(0, 20);
+		}
+		assert(rate.get_send_interval() == MAX_SEND_INTERVAL - 1);
+	}
+
+	// Test a growing round trip counts as congestion without any loss.
+	{
+		int interval = rate.get_send_interval();
+		for (int i = 0; i < 4; i++)
+		{
+			run_period(0, 20 + (int)RATE_QUEUE_THRESHOLD_MS * 4);
+		}
+		assert(rate.get_send_interval() > interval);
+	}
+
+	// Test steady random loss under the threshold never slows the link down.
+	{
+		ga_network_stats steady_stats;
+		ga_send_rate steady;
+		uint32_t random = 1;
+		steady.update(steady_stats, time);
+		for (int tick = 0; tick < 60 * 30; tick++)
+		{
+			// One packet a tick, 5% of them lost
+			random = random * 1664525u + 1013904223u;
+			if (steady.tick())
+			{
+				steady_stats.on_packet_sent(sequence, 100, time);
+				if ((random >> 8) % 100 >= 5)
+				{
+					steady_stats.on_packet_acked(sequence, time + std::chrono::milliseconds(20));
+				}
+				sequence++;
+			}
+			time += std::chrono::microseconds(1000000 / 60);
+			steady.update(steady_stats, time);
+			assert(steady.get_send_interval() == 1 && steady.get_budget_scale() == 1.0f);
+		}
+	}
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void ga_send_rate_unit_tests();
@@ -1,6 +1,13 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // For recvmmsg/sendmmsg
+#endif
 #include "ga_socket.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#if PLATFORM != PLATFORM_WINDOWS
+#include <sys/select.h>
+#endif
 
 ga_socket::ga_socket()
 {
@@ -34,8 +41,7 @@ bool ga_socket::open(unsigned int port)
 	}
 	// Set to non-blocking
 #if PLATFORM == PLATFORM_MAC || PLATFORM == PLATFORM_UNIX
-	int non_blocking = 1;
-	if (fcntl(handle, F_SETFL, O_NONBLOCK, non_blocking) == -1)
+	if (fcntl(_sock, F_SETFL, O_NONBLOCK) == -1)
 	{
 		printf("Could not set socket to non-blocking\n");
 		return false;
@@ -57,7 +63,7 @@ void ga_socket::close()
 #if PLATFORM == PLATFORM_WINDOWS
 	closesocket(_sock);
 #else
-	close(_sock);
+	::close(_sock);
 #endif
 }
 
@@ -66,6 +72,11 @@ bool ga_socket::is_open() const
 	return _sock != 0;
 }
 
+int ga_socket::get_handle() const
+{
+	return _sock;
+}
+
 bool ga_socket::send(const ga_address & dest, const void * data, int size)
 {
 	// Set up send
@@ -98,3 +109,107 @@ int ga_socket::receive(ga_address & sender, void * data, int size)
 	sender = ga_address(addr, port);
 	return received;
 }
+
+int ga_socket::send_batch(ga_packet* const* packets, int count)
+{
+#if defined(GA_SOCKET_MMSG)
+	int sent = 0;
+	while (sent < count)
+	{
+		int batch = count - sent < SOCKET_BATCH_SIZE ? count - sent : SOCKET_BATCH_SIZE;
+		mmsghdr messages[SOCKET_BATCH_SIZE];
+		iovec iovecs[SOCKET_BATCH_SIZE];
+		sockaddr_in addrs[SOCKET_BATCH_SIZE];
+		for (int i = 0; i < batch; i++)
+		{
+			const ga_packet& packet = *packets[sent + i];
+			addrs[i].sin_family = AF_INET;
+			addrs[i].sin_addr.s_addr = htonl(packet._address.get_address());
+			addrs[i].sin_port = htons(packet._address.get_port());
+			iovecs[i].iov_base = (void*)packet._data;
+			iovecs[i].iov_len = packet._size;
+			memset(&messages[i], 0, sizeof(mmsghdr));
+			messages[i].msg_hdr.msg_name = &addrs[i];
+			messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+			messages[i].msg_hdr.msg_iov = &iovecs[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+		}
+		int result = sendmmsg(_sock, messages, batch, 0);
+		if (result <= 0)
+		{
+			break;
+		}
+		sent += result;
+	}
+	return sent;
+#else
+	int sent = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (send(packets[i]->_address, packets[i]->_data, packets[i]->_size))
+		{
+			sent++;
+		}
+	}
+	return sent;
+#endif
+}
+
+int ga_socket::receive_batch(ga_packet* const* packets, int count)
+{
+#if defined(GA_SOCKET_MMSG)
+	count = count < SOCKET_BATCH_SIZE ? count : SOCKET_BATCH_SIZE;
+	mmsghdr messages[SOCKET_BATCH_SIZE];
+	iovec iovecs[SOCKET_BATCH_SIZE];
+	sockaddr_in addrs[SOCKET_BATCH_SIZE];
+	for (int i = 0; i < count; i++)
+	{
+		iovecs[i].iov_base = packets[i]->_data;
+		iovecs[i].iov_len = MAX_BUFFER;
+		memset(&messages[i], 0, sizeof(mmsghdr));
+		messages[i].msg_hdr.msg_name = &addrs[i];
+		messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+		messages[i].msg_hdr.msg_iov = &iovecs[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+	int received = recvmmsg(_sock, messages, count, MSG_DONTWAIT, NULL);
+	if (received < 0)
+	{
+		return 0;
+	}
+	std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < received; i++)
+	{
+		packets[i]->_time = now;
+		packets[i]->_size = messages[i].msg_len;
+		packets[i]->_address = ga_address(ntohl(addrs[i].sin_addr.s_addr), ntohs(addrs[i].sin_port));
+	}
+	return received;
+#else
+	int received = 0;
+	while (received < count)
+	{
+		int size = receive(packets[received]->_address, packets[received]->_data, MAX_BUFFER);
+		if (size == 0)
+		{
+			break;
+		}
+		packets[received]->_size = size;
+		packets[received]->_time = std::chrono::high_resolution_clock::now();
+		received++;
+	}
+	return received;
+#endif
+}
+
+bool ga_socket::wait(int timeout_ms)
+{
+	// Block until the socket is readable or the timeout passes
+	fd_set read_set;
+	FD_ZERO(&read_set);
+	FD_SET(_sock, &read_set);
+	timeval timeout;
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_usec = (timeout_ms % 1000) * 1000;
+	return select(_sock + 1, &read_set, NULL, NULL, &timeout) > 0;
+}
@@ -15,21 +15,27 @@
 
 #if PLATFORM == PLATFORM_WINDOWS
 #include <winsock2.h>
-#elif PLATFORM == PLATFORM_MAC || PLATFORM_UNIX
+#elif PLATFORM == PLATFORM_MAC || PLATFORM == PLATFORM_UNIX
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <arpa/inet.h>
 #include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Linux can move a whole batch of datagrams per syscall
+#if PLATFORM == PLATFORM_UNIX && defined(__linux__)
+#define GA_SOCKET_MMSG
 #endif
 
 #if PLATFORM == PLATFORM_WINDOWS
 #pragma comment(lib, "wsock32.lib")
 #endif
 
-#define MAX_BUFFER 256
+#include "ga_transport.h"
 
-#include "ga_address.h"
 // Socket header from http://gafferongames.com/networking-for-game-programmers/sending-and-receiving-packets/
-class ga_socket
+class ga_socket : public ga_transport
 {
 public:
 	ga_socket();
@@ -37,8 +43,12 @@ public:
 	bool open(unsigned int port);
 	void close();
 	bool is_open() const;
+	virtual int get_handle() const override;
 	bool send(const ga_address & dest, const void* data, int size);
 	int receive(ga_address & sender, void * data, int size);
+	virtual int send_batch(ga_packet* const* packets, int count) override;
+	virtual int receive_batch(ga_packet* const* packets, int count) override;
+	virtual bool wait(int timeout_ms) override;
 private:
 	int _sock;
 };
\ No newline at end of file
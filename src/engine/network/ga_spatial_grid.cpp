@@ -0,0 +1,81 @@
+#include "ga_spatial_grid.h"
+#include <cmath>
+
+ga_spatial_grid::ga_spatial_grid()
+{
+	_cell_size = 1.0f;
+	_bucket_mask = 0;
+}
+
+void ga_spatial_grid::build(const ga_vec3f* positions, int count, float cell_size)
+{
+	_cell_size = cell_size;
+	int bucket_count = 64;
+	while (bucket_count < count * 2)
+	{
+		bucket_count <<= 1;
+	}
+	_bucket_mask = bucket_count - 1;
+	_positions.assign(positions, positions + count);
+	_buckets.resize(count);
+	_entities.resize(count);
+
+	// Counting sort of entities by bucket. Each start first becomes the end
+	// of its bucket, then is walked back to the start while filling.
+	_bucket_start.assign(bucket_count + 1, 0);
+	for (int e = 0; e < count; e++)
+	{
+		_buckets[e] = get_bucket(get_cell(positions[e].x), get_cell(positions[e].z));
+		_bucket_start[_buckets[e]]++;
+	}
+	for (int b = 1; b < bucket_count; b++)
+	{
+		_bucket_start[b] += _bucket_start[b - 1];
+	}
+	_bucket_start[bucket_count] = count;
+	for (int e = count - 1; e >= 0; e--)
+	{
+		_entities[--_bucket_start[_buckets[e]]] = e;
+	}
+}
+
+void ga_spatial_grid::query(const ga_vec3f& center, float radius, uint64_t* mask) const
+{
+	if (_positions.empty())
+	{
+		return;
+	}
+	float radius2 = radius * radius;
+	int min_x = get_cell(center.x - radius);
+	int max_x = get_cell(center.x + radius);
+	int min_z = get_cell(center.z - radius);
+	int max_z = get_cell(center.z + radius);
+	for (int x = min_x; x <= max_x; x++)
+	{
+		for (int z = min_z; z <= max_z; z++)
+		{
+			// Buckets may hold other cells too; the distance test sorts them out
+			int bucket = get_bucket(x, z);
+			for (int i = _bucket_start[bucket]; i < _bucket_start[bucket + 1]; i++)
+			{
+				int e = _entities[i];
+				if (_positions[e].dist2(center) <= radius2)
+				{
+					mask[e >> 6] |= 1ull << (e & 63);
+				}
+			}
+		}
+	}
+}
+
+int ga_spatial_grid::get_bucket(int cell_x, int cell_z) const
+{
+	unsigned int h = (unsigned int)cell_x * 0x9e3779b1u ^ (unsigned int)cell_z * 0x85ebca6bu;
+	h ^= h >> 15;
+	return h & _bucket_mask;
+}
+
+int ga_spatial_grid::get_cell(float coordinate) const
+{
+	return (int)floorf(coordinate / _cell_size);
+}
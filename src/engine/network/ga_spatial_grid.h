@@ -0,0 +1,33 @@
+#pragma once
+#include "math/ga_vec3f.h"
+#include <cstdint>
+#include <vector>
+
+/*
+** Buckets entity positions into square cells on the XZ plane so that
+** everything near a point can be found without visiting every entity.
+** Cells are hashed into a fixed bucket array sized from the entity count;
+** rebuilding reuses its storage.
+*/
+class ga_spatial_grid
+{
+public:
+	ga_spatial_grid();
+
+	void build(const ga_vec3f* positions, int count, float cell_size);
+
+	// Sets the bit of every entity within radius of center. The mask holds
+	// one bit per entity, 64 to a block, and is not cleared first.
+	void query(const ga_vec3f& center, float radius, uint64_t* mask) const;
+
+private:
+	int get_bucket(int cell_x, int cell_z) const;
+	int get_cell(float coordinate) const;
+
+	float _cell_size;
+	int _bucket_mask;
+	std::vector<ga_vec3f> _positions;
+	std::vector<int> _buckets;
+	std::vector<int> _bucket_start;
+	std::vector<int> _entities;
+};
@@ -0,0 +1,33 @@
+#include "ga_spatial_grid.tests.h"
+#include "ga_spatial_grid.h"
+
+#include <cassert>
+
+void ga_spatial_grid_unit_tests()
+{
+	// Test queries find exactly the entities in range, across cells.
+	{
+		ga_vec3f positions[] =
+		{
+			{ 0.0f, 0.0f, 0.0f },
+			{ 3.0f, 0.0f, 0.0f },
+			{ 0.0f, 0.0f, -9.0f },
+			{ 100.0f, 0.0f, 0.0f },
+			{ 0.0f, 40.0f, 0.0f },
+		};
+		ga_spatial_grid grid;
+		grid.build(positions, 5, 5.0f);
+
+		uint64_t mask = 0;
+		grid.query({ 0.5f, 0.0f, 0.0f }, 5.0f, &mask);
+		assert(mask == 3);
+
+		mask = 0;
+		grid.query({ 0.0f, 0.0f, 0.0f }, 10.0f, &mask);
+		assert(mask == 7);
+
+		mask = 0;
+		grid.query({ 98.0f, 0.0f, 1.0f }, 5.0f, &mask);
+		assert(mask == 8);
+	}
+}
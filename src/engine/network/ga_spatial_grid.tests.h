@@ -0,0 +1,3 @@
+#pragma once
+
+void ga_spatial_grid_unit_tests();
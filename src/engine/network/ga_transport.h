@@ -0,0 +1,41 @@
+#pragma once
+#include "ga_address.h"
+#include <chrono>
+
+// Largest datagram we send or receive. Snapshots bigger than the MTU are fragmented.
+#define MAX_BUFFER 1500
+
+#define SOCKET_BATCH_SIZE 64
+
+/*
+** One datagram in a batched send or receive.
+** Received packets are stamped with their arrival time.
+*/
+struct ga_packet
+{
+	ga_address _address;
+	std::chrono::high_resolution_clock::time_point _time;
+	int _size;
+	unsigned char _data[MAX_BUFFER];
+};
+
+/*
+** Unreliable datagram transport the client, server and network thread talk
+** through. Implemented by ga_socket for real UDP and ga_loopback_transport
+** for in-process simulation.
+*/
+class ga_transport
+{
+public:
+	virtual ~ga_transport() {}
+
+	// Both return how many packets were sent or received; neither blocks.
+	virtual int send_batch(ga_packet* const* packets, int count) = 0;
+	virtual int receive_batch(ga_packet* const* packets, int count) = 0;
+
+	// Blocks until a packet can be received or the timeout passes.
+	virtual bool wait(int timeout_ms) = 0;
+
+	// Descriptor a poller can wait on, or -1 if the transport must be polled.
+	virtual int get_handle() const = 0;
+};
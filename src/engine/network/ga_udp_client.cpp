@@ -1,19 +1,61 @@
 #include "ga_udp_client.h"
-#include <string>
-#include <sstream>
+#include "ga_bitstream.h"
+#include <cstdio>
+#include <cstring>
 ga_udp_client::ga_udp_client(short port, ga_address server, ga_sim* sim)
 {
 	initialize_sockets();
 	_socket = new ga_socket();
 	_socket->open(port);
+	initialize(_socket, server, sim);
+}
+
+ga_udp_client::ga_udp_client(ga_transport* transport, ga_address server, ga_sim* sim)
+{
+	initialize_sockets();
+	_socket = NULL;
+	initialize(transport, server, sim);
+}
+
+void ga_udp_client::initialize(ga_transport* transport, ga_address server, ga_sim* sim)
+{
+	_transport = transport;
 	_server = server;
 	_sim = sim;
-	char* buffer = "Connect";
-	_socket->send(server, buffer, strlen(buffer));
+	_factory = NULL;
+	// Received snapshots are kept by id so later diffs can be rebuilt on top of them
+	_dummy = ga_snapshot(_sim->num_entities());
+	_snapshots.assign(MAX_SNAPSHOTS, _dummy);
+	_mtu = DEFAULT_MTU;
+	_reassembly = new ga_reassembly_buffer(_mtu - PACKET_HEADER_SIZE - SNAPSHOT_INFO_SIZE - RELIABLE_HEADER_SIZE);
+	_interpolation = new ga_interpolation_buffer(_sim->num_entities());
+	_pool = new ga_packet_pool(CLIENT_PACKET_POOL_SIZE);
+	_received_since_send = 0;
+	_stats_interval = std::chrono::milliseconds(0);
+	_last_stats = std::chrono::high_resolution_clock::now();
+	_tick_time = _last_stats;
+	_next_input = 0;
+	_acked_input = 0xffff;
+	_tick_rate = 60;
+	_command_rate = 30;
+	_ticks_since_command = 0;
+	_player = NO_PLAYER_ENTITY;
+	_connected = false;
+	send_connect();
 }
 
 ga_udp_client::~ga_udp_client()
 {
+	for (int e = 0; _factory && e < (int)_entities.size(); e++)
+	{
+		if (_entities[e])
+		{
+			_factory->despawn(e, _entities[e]);
+		}
+	}
+	delete _interpolation;
+	delete _reassembly;
+	delete _pool;
 	delete _socket;
 	shutdown_sockets();
 }
@@ -36,60 +78,301 @@ void ga_udp_client::shutdown_sockets()
 #endif
 }
 
+void ga_udp_client::set_mtu(int mtu)
+{
+	// Must match the server's MTU
+	_mtu = mtu;
+	delete _reassembly;
+	_reassembly = new ga_reassembly_buffer(_mtu - PACKET_HEADER_SIZE - SNAPSHOT_INFO_SIZE - RELIABLE_HEADER_SIZE);
+}
+
+void ga_udp_client::set_tick_rate(int ticks_per_second)
+{
+	_tick_rate = ticks_per_second;
+	// Must match the server's tick rate, snapshots are timed by tick
+	_interpolation->set_tick_interval(std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+		std::chrono::microseconds(1000000 / ticks_per_second)));
+}
+
+void ga_udp_client::set_command_rate(int commands_per_second)
+{
+	_command_rate = commands_per_second;
+}
+
+void ga_udp_client::set_interpolation_delay(std::chrono::milliseconds delay)
+{
+	_interpolation->set_delay(delay);
+}
+
+bool ga_udp_client::send_message(const void* data, int size)
+{
+	return _channel.send(data, size);
+}
+
+bool ga_udp_client::receive_message(std::vector<uint8_t>* message)
+{
+	return _channel.receive(message);
+}
+
+void ga_udp_client::set_entity_factory(ga_entity_factory* factory)
+{
+	_factory = factory;
+}
+
+ga_entity* ga_udp_client::get_entity(uint16_t id) const
+{
+	return id < _entities.size() ? _entities[id] : NULL;
+}
+
+void ga_udp_client::set_stats_interval(std::chrono::milliseconds interval)
+{
+	_stats_interval = interval;
+}
+
+const ga_network_stats& ga_udp_client::get_stats() const
+{
+	return _stats;
+}
+
 void ga_udp_client::update(struct ga_frame_params* params) {
-	// Send and commands being pressed
-	unsigned int keyboard = params->_button_mask;
-	char* buffer = new char[MAX_BUFFER];
-	if (keyboard != 0)
+	// Sends and stats run on the frame's clock, as the server's do
+	_tick_time = params->_current_time;
+
+	// Number this tick's input and apply it locally straight away
+	ga_input_command& input = _inputs[_next_input % INPUT_HISTORY_SIZE];
+	input._number = _next_input++;
+	input._buttons = (uint32_t)params->_button_mask;
+	if (_player != NO_PLAYER_ENTITY)
+	{
+		ga_apply_input_command(input, &_predicted);
+	}
+	// Keep asking to connect, about once a second, until a snapshot arrives
+	if (!_connected && ++_ticks_since_connect >= _tick_rate)
+	{
+		send_connect();
+	}
+	// Inputs go out in batches at the command rate, which also carry our acks
+	int ticks_per_command = _command_rate < _tick_rate ? _tick_rate / _command_rate : 1;
+	if (++_ticks_since_command >= ticks_per_command)
 	{
-		sprintf(buffer, "Key %d", keyboard);
+		send_inputs();
 	}
-	send(buffer);
-	delete buffer;
 
 	// Receive new snapshots from server
-	ga_address sender;
-	buffer = receive(sender);
-	if (buffer != NULL)
-	{
-		int snapshot_id;
-		std::istringstream is(buffer);
-		std::string token;
-		int i = 0, axis = 0;
-		float pos = 0.0f;
-		is >> snapshot_id;
-		while (is)
+	ga_packet_ref packet(_pool);
+	while (packet && receive(packet.get()))
+	{
+		ga_packet_header header;
+		if (!ga_read_packet_header(packet->_data, packet->_size, &header))
+		{
+			continue;
+		}
+		_stats.on_packet_received(packet->_size, packet->_time);
+		bool fresh = _acks.process_header(header);
+		for (int i = 0; i < _acks.get_acked_count(); i++)
+		{
+			_stats.on_packet_acked(_acks.get_acked(i), packet->_time);
+			_channel.on_packet_acked(_acks.get_acked(i));
+		}
+		int offset = PACKET_HEADER_SIZE + SNAPSHOT_INFO_SIZE;
+		if (!fresh || packet->_size < offset + RELIABLE_HEADER_SIZE)
+		{
+			continue;
+		}
+		// A large snapshot can outrun the ack window, so ack early if needed
+		if (++_received_since_send >= 32)
 		{
-			is >> token;
-			if (token == std::string("Box"))
+			send(NULL, 0);
+		}
+		// Reliable messages come first, then a fragment if the packet has one.
+		// Wait until every fragment of a snapshot has arrived
+		int block = _channel.read(packet->_data + offset, packet->_size - offset);
+		if (block < 0)
+		{
+			continue;
+		}
+		offset += block;
+		const uint8_t* payload;
+		int size = _reassembly->add_fragment(packet->_data + offset, packet->_size - offset, &payload);
+		const ga_snapshot* snapshot = NULL;
+		if (size > 0)
+		{
+			snapshot = handle_snapshot(payload, size, _reassembly->get_last_completed(), packet->_time);
+		}
+		if (snapshot)
+		{
+			ga_bit_reader info(packet->_data + PACKET_HEADER_SIZE, SNAPSHOT_INFO_SIZE);
+			uint16_t last_input = info.read_bits(16);
+			uint16_t player = info.read_bits(16);
+			reconcile(*snapshot, last_input, player);
+		}
+	}
+
+	// Show entities where they were a little while ago, between two snapshots
+	if (_interpolation->set_time(params->_current_time))
+	{
+		update_entities();
+		for (int e = 0; e < (int)_entities.size(); e++)
+		{
+			if (_entities[e])
 			{
-				is >> i >> axis >> pos;
-				ga_entity* ent = _sim->get_entity(i);
-				ga_vec3f trans = ga_vec3f::zero_vector();
-				trans.axes[axis] = pos - ent->get_transform().get_translation().axes[axis];
-				ent->translate(trans);
+				_entities[e]->set_transform(_interpolation->get_transform(e));
 			}
 		}
-		// Parse buffer and update new positions
-		// Send ACK to server
-		sprintf(buffer, "ACK %d", snapshot_id);
-		send(buffer);
 	}
+	// Except our own entity, which is shown where we predict it is now
+	ga_entity* player = _player != NO_PLAYER_ENTITY ? get_entity(_player) : NULL;
+	if (player)
+	{
+		player->set_transform(_predicted);
+	}
+
+	if (_stats_interval.count() > 0 && _tick_time - _last_stats >= _stats_interval)
+	{
+		ga_print_network_stats("client", _stats);
+		_last_stats = _tick_time;
+	}
+}
+
+const ga_snapshot* ga_udp_client::handle_snapshot(const uint8_t* payload, int size, uint16_t sequence, std::chrono::high_resolution_clock::time_point received)
+{
+	ga_bit_reader reader(payload, size);
+	int snapshot_id = reader.read_bits(8);
+	int baseline_id = reader.read_bits(8);
+	if (snapshot_id >= MAX_SNAPSHOTS || (baseline_id >= MAX_SNAPSHOTS && baseline_id != NO_BASELINE))
+	{
+		return NULL;
+	}
+	const ga_snapshot& source = baseline_id == NO_BASELINE ? _dummy : _snapshots[baseline_id];
+	ga_snapshot& curr = _snapshots[snapshot_id];
+	auto start = std::chrono::high_resolution_clock::now();
+	if (!ga_snapshot::patch(source, &reader, &curr))
+	{
+		return NULL;
+	}
+	_stats._snapshot_us.add(std::chrono::duration<float, std::micro>(std::chrono::high_resolution_clock::now() - start).count());
+	_stats._snapshot_bytes.add((float)size);
+	// Entities are moved from the interpolation buffer, not straight away.
+	// The server learns we have this snapshot from the acks on our next packet.
+	_interpolation->add(curr, sequence, received);
+	_connected = true;
+	return &curr;
 }
 
-int ga_udp_client::send(const void * data)
+void ga_udp_client::reconcile(const ga_snapshot& snapshot, uint16_t last_input, uint16_t player)
 {
-	return _socket->send(_server, data, strlen((char*)data));
+	if (!snapshot.is_live(player))
+	{
+		_player = NO_PLAYER_ENTITY;
+		return;
+	}
+	_player = player;
+	_acked_input = last_input;
+
+	// Rewind to where the server had us after our last applied input, then
+	// replay every input it has not seen yet on top
+	_predicted = snapshot.get_transform(player);
+	uint16_t first = last_input + 1;
+	if ((uint16_t)(_next_input - first) > INPUT_HISTORY_SIZE)
+	{
+		first = _next_input - INPUT_HISTORY_SIZE;
+	}
+	for (uint16_t number = first; number != _next_input; number++)
+	{
+		const ga_input_command& input = _inputs[number % INPUT_HISTORY_SIZE];
+		if (input._number == number)
+		{
+			ga_apply_input_command(input, &_predicted);
+		}
+	}
 }
 
-char* ga_udp_client::receive(ga_address& sender)
+void ga_udp_client::update_entities()
 {
-	char* buffer = new char[MAX_BUFFER];
-	int read = _socket->receive(sender, buffer, MAX_BUFFER);
-	if (read == 0)
+	// Entities exist while the snapshot being shown has them live
+	int count = _interpolation->num_entities();
+	if ((int)_entities.size() < count)
 	{
-		return NULL;
+		_entities.resize(count, NULL);
 	}
-	buffer[read] = '\0';
-	return buffer;
+	for (int e = 0; e < (int)_entities.size(); e++)
+	{
+		bool live = _interpolation->is_live(e);
+		if (live && !_entities[e])
+		{
+			if (_factory)
+			{
+				_entities[e] = _factory->spawn(e);
+			}
+			else if (e < _sim->num_entities())
+			{
+				_entities[e] = _sim->get_entity(e);
+			}
+		}
+		else if (!live && _entities[e])
+		{
+			if (_factory)
+			{
+				_factory->despawn(e, _entities[e]);
+			}
+			_entities[e] = NULL;
+		}
+	}
+}
+
+void ga_udp_client::send_connect()
+{
+	// Not a reliable message: the server only creates its end of the
+	// channel, and only starts acking, once a connect arrives. Instead it
+	// is repeated until the first snapshot shows it got through
+	uint8_t connect = k_message_connect;
+	send(&connect, 1);
+	_ticks_since_connect = 0;
+}
+
+void ga_udp_client::send_inputs()
+{
+	// Repeat every input the server has not applied yet, up to a limit
+	uint16_t newest = _next_input - 1;
+	int count = (uint16_t)(newest - _acked_input);
+	count = count < INPUT_REDUNDANCY ? count : INPUT_REDUNDANCY;
+
+	uint8_t body[64];
+	ga_bit_writer writer(body, sizeof(body));
+	if (count > 0)
+	{
+		writer.write_bits(k_message_input, 8);
+		ga_write_input_batch(_inputs, newest, count, &writer);
+	}
+	send(body, writer.get_bytes_written());
+}
+
+int ga_udp_client::send(const uint8_t* body, int size)
+{
+	ga_packet_ref packet(_pool);
+	if (!packet)
+	{
+		return 0;
+	}
+	ga_packet_header header;
+	_acks.prepare_header(&header);
+	packet->_size = ga_write_packet_header(header, packet->_data);
+	auto now = _tick_time;
+	packet->_size += _channel.write(header._sequence, now, _stats.get_rtt_timeout_ms(), packet->_data + packet->_size, _mtu - packet->_size - size);
+	if (size > 0)
+	{
+		memcpy(packet->_data + packet->_size, body, size);
+		packet->_size += size;
+	}
+	_received_since_send = 0;
+	_ticks_since_command = 0;
+	_stats.on_packet_sent(header._sequence, packet->_size, now);
+	packet->_address = _server;
+	ga_packet* batch = packet.get();
+	return _transport->send_batch(&batch, 1) == 1;
+}
+
+bool ga_udp_client::receive(ga_packet* packet)
+{
+	return _transport->receive_batch(&packet, 1) == 1;
 }
@@ -1,21 +1,106 @@
 #pragma once
 #include "ga_socket.h"
+#include "ga_fragment.h"
+#include "ga_packet_header.h"
+#include "ga_interpolation_buffer.h"
+#include "ga_input_command.h"
+#include "ga_packet_pool.h"
+#include "ga_network_stats.h"
+#include "ga_reliable_channel.h"
 #include "framework/ga_frame_params.h"
+#include "framework/ga_snapshot.h"
 #include "framework/ga_sim.h"
 #include "entity/ga_entity.h"
+
+#define CLIENT_PACKET_POOL_SIZE 8
+
+/*
+** Creates and destroys the client's copies of server entities as they come
+** into and go out of existence, by network id.
+*/
+class ga_entity_factory
+{
+public:
+	virtual ~ga_entity_factory() {}
+
+	// May return NULL to not show this entity.
+	virtual ga_entity* spawn(uint16_t id) = 0;
+	virtual void despawn(uint16_t id, ga_entity* entity) = 0;
+};
+
 class ga_udp_client
 {
 public:
 	ga_udp_client(short port, ga_address server, ga_sim* sim);
+
+	// Runs over a transport the caller owns, such as a loopback one
+	ga_udp_client(ga_transport* transport, ga_address server, ga_sim* sim);
 	~ga_udp_client();
 	bool initialize_sockets();
 	void shutdown_sockets();
 	void update(struct ga_frame_params* params);
+	void set_mtu(int mtu);
+	void set_tick_rate(int ticks_per_second);
+	void set_command_rate(int commands_per_second);
+	void set_interpolation_delay(std::chrono::milliseconds delay);
+
+	// Queues a message for the server, delivered reliably and in order with
+	// later packets. False if the queue is full, see ga_reliable_channel.
+	bool send_message(const void* data, int size);
+
+	// Pops the next message the server sent, in order.
+	bool receive_message(std::vector<uint8_t>* message);
+
+	// Without a factory, network ids map to the sim's entities by index and
+	// those past the end of the sim are not shown. The factory must outlive
+	// the client, and should be set before the first update.
+	void set_entity_factory(ga_entity_factory* factory);
+
+	// The entity shown for a network id, or NULL if it does not exist now.
+	ga_entity* get_entity(uint16_t id) const;
+
+	// Prints this connection's stats this often. Zero, the default, never does.
+	void set_stats_interval(std::chrono::milliseconds interval);
+	const ga_network_stats& get_stats() const;
 private:
-	int send(const void* data);
-	char* receive(ga_address& sender);
+	void initialize(ga_transport* transport, ga_address server, ga_sim* sim);
+	const ga_snapshot* handle_snapshot(const uint8_t* payload, int size, uint16_t sequence, std::chrono::high_resolution_clock::time_point received);
+	void reconcile(const ga_snapshot& snapshot, uint16_t last_input, uint16_t player);
+	void update_entities();
+	void send_connect();
+	void send_inputs();
+	int send(const uint8_t* body, int size);
+	bool receive(ga_packet* packet);
 	// Representation
 	ga_socket* _socket;
+	ga_transport* _transport;
 	ga_address _server;
 	ga_sim* _sim;
+	ga_entity_factory* _factory;
+	std::vector<ga_entity*> _entities;
+	ga_snapshot _dummy;
+	std::vector<ga_snapshot> _snapshots;
+	ga_packet_pool* _pool;
+	ga_reassembly_buffer* _reassembly;
+	ga_interpolation_buffer* _interpolation;
+	ga_ack_tracker _acks;
+	ga_reliable_channel _channel;
+	ga_network_stats _stats;
+	std::chrono::milliseconds _stats_interval;
+	std::chrono::high_resolution_clock::time_point _last_stats;
+	std::chrono::high_resolution_clock::time_point _tick_time;
+	int _mtu;
+	int _received_since_send;
+	bool _connected;
+	int _ticks_since_connect;
+
+	// Client side prediction of the entity we control
+	ga_input_command _inputs[INPUT_HISTORY_SIZE];
+	uint16_t _next_input;
+	uint16_t _acked_input;
+	int _tick_rate;
+	int _command_rate;
+	int _ticks_since_command;
+	uint16_t _player;
+	ga_mat4f _predicted;
 };
\ No newline at end of file
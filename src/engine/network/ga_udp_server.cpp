@@ -1,21 +1,146 @@
 #include "ga_udp_server.h"
+#include "ga_bitstream.h"
+#include "jobs/ga_job.h"
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
+#include <malloc.h>
+#include <utility>
+
+static const int k_invalid_baseline = -2;
+
+// Priority gained per tick held back is scaled up by speed, in units moved
+// per tick, and down by distance from the client's entity
+static const float k_speed_priority = 10.0f;
+static const float k_distance_priority = 0.1f;
+
 ga_udp_server::ga_udp_server(short port, ga_sim* sim)
 {
 	initialize_sockets();
 	_socket = new ga_socket();
 	_socket->open(port);
+	initialize(_socket, sim);
+}
+
+ga_udp_server::ga_udp_server(ga_transport* transport, ga_sim* sim)
+{
+	initialize_sockets();
+	_socket = NULL;
+	initialize(transport, sim);
+}
+
+void ga_udp_server::initialize(ga_transport* transport, ga_sim* sim)
+{
 	_sim = sim;
-	_dummy = ga_snapshot(_sim->num_entities());
+	_player_factory = NULL;
+	_dummy = ga_snapshot(0);
+	_history.assign(MAX_SNAPSHOTS, _dummy);
+	_history_sequences.assign(MAX_SNAPSHOTS, 0);
 	_snapshot_offset = 0;
+	_snapshot_sequence = 0;
+	for (int e = 0; e < _sim->num_entities(); e++)
+	{
+		add_entity(_sim->get_entity(e));
+	}
+	_mtu = DEFAULT_MTU;
+	_interest_radius = 0.0f;
+	_snapshot_budget = 0;
+	_adaptive_rate = true;
+	_stats_interval = std::chrono::milliseconds(0);
+	_last_stats = std::chrono::high_resolution_clock::now();
+	_tick_time = _last_stats;
+	// Clients keep their slot for as long as they stay connected
+	_client_table = new ga_client_table(MAX_CLIENTS);
+	_clients.assign(MAX_CLIENTS, NULL);
+	_pool = new ga_packet_pool(SERVER_PACKET_POOL_SIZE);
+	// The network thread owns the transport from here on
+	_network = new ga_network_thread(transport, _pool);
+	_network->set_inbound_listener(&_tick_poller);
 }
 
 ga_udp_server::~ga_udp_server()
 {
+	for (int c = 0; c < (int)_clients.size(); c++)
+	{
+		if (_clients[c])
+		{
+			drop_client(c);
+		}
+	}
+	delete _client_table;
+	delete _network;
+	delete _pool;
 	delete _socket;
 	shutdown_sockets();
 }
 
+int ga_udp_server::add_entity(ga_entity* entity)
+{
+	// A freed id is reusable once every baseline has it dead
+	int id;
+	if (!_freed_ids.empty() && (uint16_t)(_snapshot_sequence - _freed_ids.front()._sequence) >= MAX_SNAPSHOTS)
+	{
+		id = _freed_ids.front()._id;
+		_freed_ids.pop_front();
+	}
+	else if (_entities.size() < MAX_NETWORK_ENTITIES)
+	{
+		id = (int)_entities.size();
+		_entities.push_back(NULL);
+	}
+	else
+	{
+		return -1;
+	}
+	_entities[id] = entity;
+
+	// Every snapshot has room for every id, so any two can be diffed
+	if (id >= _dummy.num_entities())
+	{
+		int capacity = _dummy.num_entities() > 0 ? _dummy.num_entities() * 2 : 64;
+		capacity = capacity < MAX_NETWORK_ENTITIES ? capacity : MAX_NETWORK_ENTITIES;
+		_dummy.resize(capacity);
+		for (int i = 0; i < MAX_SNAPSHOTS; i++)
+		{
+			_history[i].resize(capacity);
+		}
+	}
+	return id;
+}
+
+void ga_udp_server::remove_entity(uint16_t id)
+{
+	if (id < _entities.size() && _entities[id])
+	{
+		_entities[id] = NULL;
+		_freed_ids.push_back({ id, _snapshot_sequence });
+
+		// A client left controlling a removed entity controls nothing
+		for (int c = 0; c < (int)_clients.size(); c++)
+		{
+			if (_clients[c] && _clients[c]->_player == id)
+			{
+				_clients[c]->_player = NO_PLAYER_ENTITY;
+			}
+		}
+	}
+}
+
+ga_entity* ga_udp_server::get_entity(uint16_t id) const
+{
+	return id < _entities.size() ? _entities[id] : NULL;
+}
+
+void ga_udp_server::set_player_factory(ga_player_factory* factory)
+{
+	_player_factory = factory;
+}
+
+uint16_t ga_udp_server::get_player(int client) const
+{
+	return _clients[client]->_player;
+}
+
 bool ga_udp_server::initialize_sockets()
 {
 #if PLATFORM == PLATFORM_WINDOWS
@@ -34,152 +159,722 @@ void ga_udp_server::shutdown_sockets()
 #endif
 }
 
-void ga_udp_server::handle_command(char* buffer, ga_address sender)
+void ga_udp_server::set_mtu(int mtu)
 {
-	if (strcmp(buffer,"Connect") == 0)
+	int min_mtu = PACKET_HEADER_SIZE + SNAPSHOT_INFO_SIZE + RELIABLE_HEADER_SIZE + FRAGMENT_HEADER_SIZE + 1;
+	_mtu = mtu < min_mtu ? min_mtu : mtu;
+	_mtu = _mtu > MAX_BUFFER ? MAX_BUFFER : _mtu;
+}
+
+void ga_udp_server::set_interest_radius(float radius)
+{
+	_interest_radius = radius;
+}
+
+void ga_udp_server::set_snapshot_budget(int bytes)
+{
+	_snapshot_budget = bytes;
+}
+
+void ga_udp_server::set_adaptive_rate(bool enabled)
+{
+	_adaptive_rate = enabled;
+}
+
+void ga_udp_server::handle_packet(ga_packet* packet)
+{
+	ga_packet_header header;
+	if (!ga_read_packet_header(packet->_data, packet->_size, &header))
 	{
-		// Add addr to 
-		if (_clients.size() < 4)
-		{
-			_clients.push_back(sender);
-			snapshot_array tmp;
-			for (int i = 0; i < MAX_SNAPSHOTS; i++)
-			{
-				ga_snapshot snap(_sim->num_entities());
-				for (int e = 0; e < _sim->num_entities(); e++)
-				{
-					snap.add_entity(e, *(_sim->get_entity(e)));
-				}
-				tmp.push_back(snap);
-			}
-			_client_snapshots.push_back(tmp);
-			_prev_states.push_back(-1);
-		}
+		return;
 	}
-	else if (strstr(buffer, "Key"))
+	const uint8_t* body = packet->_data + PACKET_HEADER_SIZE;
+	int size = packet->_size - PACKET_HEADER_SIZE;
+
+	int c = _client_table->find(packet->_address);
+	if (c == -1)
 	{
-		// Handle keyboard input
-		int keyboard_mask = 0;
-		char* newbuff = new char[MAX_BUFFER];
-		sscanf(buffer, "%s %d", newbuff, &keyboard_mask);
-		// Get which box to control
-		int player_no;
-		for (player_no = 0; player_no < _clients.size(); player_no++)
+		int block = ga_reliable_channel::get_block_size(body, size);
+		if (block < 0 || block >= size || body[block] != k_message_connect)
 		{
-			if (sender.get_address() == _clients[player_no].get_address() &&
-				sender.get_port() == _clients[player_no].get_port())
-			{
-				break;
-			}
+			return;
 		}
-		ga_entity* box = _sim->get_entity(player_no);
-		ga_vec3f trans = ga_vec3f::zero_vector();
-		if (keyboard_mask & k_button_j)
+		c = _client_table->insert(packet->_address);
+		if (c == -1)
 		{
-			trans.x = -0.2f;
+			return;
 		}
-		else if (keyboard_mask & k_button_l)
+		ga_server_client* client = new ga_server_client();
+		client->_address = packet->_address;
+		client->_acked_sequence = -1;
+		// Clients number inputs from 0, which counts as newer than this
+		client->_last_input = 0xffff;
+		for (int i = 0; i < MAX_SNAPSHOTS; i++)
 		{
-			trans.x = 0.2f;
+			client->_unacked_fragments[i] = 0;
 		}
-		else if (keyboard_mask & k_button_i)
+		_clients[c] = client;
+		client->_player = _player_factory ? _player_factory->spawn(c) : NO_PLAYER_ENTITY;
+	}
+
+	// Acks ride along on every packet, so handle them before the message
+	ga_server_client* client = _clients[c];
+	client->_last_received = packet->_time;
+	client->_stats.on_packet_received(packet->_size, packet->_time);
+	bool fresh = client->_acks.process_header(header);
+	for (int i = 0; i < client->_acks.get_acked_count(); i++)
+	{
+		client->_stats.on_packet_acked(client->_acks.get_acked(i), packet->_time);
+		client->_channel.on_packet_acked(client->_acks.get_acked(i));
+		handle_ack(client, client->_acks.get_acked(i));
+	}
+	// Reliable messages come first, then what is sent unreliably
+	int block = fresh ? client->_channel.read(body, size) : -1;
+	if (block >= 0)
+	{
+		handle_message(body + block, size - block, c);
+	}
+}
+
+void ga_udp_server::handle_message(const uint8_t* body, int size, int client)
+{
+	if (size == 0 || body[0] != k_message_input)
+	{
+		return;
+	}
+	ga_bit_reader reader(body + 1, size - 1);
+	ga_input_command commands[INPUT_REDUNDANCY];
+	int count = ga_read_input_batch(&reader, commands);
+
+	// Inputs are repeated across packets; only apply the ones not seen yet
+	ga_server_client* sender = _clients[client];
+	for (int i = 0; i < count; i++)
+	{
+		if (!ga_sequence_greater(commands[i]._number, sender->_last_input))
 		{
-			trans.z = -0.2f;
+			continue;
 		}
-		else if (keyboard_mask & k_button_k)
+		sender->_last_input = commands[i]._number;
+
+		ga_entity* box = get_entity(sender->_player);
+		if (box)
 		{
-			trans.z = 0.2f;
+			ga_mat4f transform = box->get_transform();
+			ga_apply_input_command(commands[i], &transform);
+			box->set_transform(transform);
 		}
-		box->translate(trans);
 	}
-	else if (strstr(buffer, "ACK"))
+}
+
+void ga_udp_server::handle_ack(ga_server_client* client, uint16_t packet_sequence)
+{
+	// Ignore packets without a fragment, and fragments of a snapshot the
+	// history ring has since overwritten
+	int sequence = client->_packet_snapshots[packet_sequence % ACK_HISTORY_SIZE];
+	if (sequence == -1)
+	{
+		return;
+	}
+	int offset = sequence % MAX_SNAPSHOTS;
+	if (_history_sequences[offset] != sequence || --client->_unacked_fragments[offset] != 0)
 	{
-		int snapshot_id = 0;
-		// Received an ACK of a snapshot, mark it down in the snapshot history
-		sscanf(buffer, "%s %d", buffer, &snapshot_id);
-		int player_no;
-		for (player_no = 0; player_no < _clients.size(); player_no++)
+		return;
+	}
+	// Only move the baseline forward
+	if (client->_acked_sequence == -1 || ga_sequence_greater(sequence, client->_acked_sequence))
+	{
+		client->_acked_sequence = sequence;
+	}
+}
+
+void ga_udp_server::drop_client(int client)
+{
+	// Take the client's entity back before its slot can be handed out again
+	uint16_t player = _clients[client]->_player;
+	if (_player_factory && player != NO_PLAYER_ENTITY)
+	{
+		_player_factory->despawn(client, player);
+	}
+	delete _clients[client];
+	_clients[client] = NULL;
+	_client_table->remove(client);
+}
+
+void ga_udp_server::drop_timed_out_clients()
+{
+	// Free the slot of anyone we have not heard from in a while
+	auto timeout = std::chrono::milliseconds(CLIENT_TIMEOUT_MS);
+	for (int c = 0; c < (int)_clients.size(); c++)
+	{
+		if (_clients[c] && _tick_time - _clients[c]->_last_received > timeout)
 		{
-			if (sender.get_address() == _clients[player_no].get_address() &&
-				sender.get_port() == _clients[player_no].get_port())
-			{
-				break;
-			}
+			drop_client(c);
 		}
-		_prev_states[player_no] = snapshot_id;
-		_client_snapshots[player_no][snapshot_id].ack();
 	}
 }
+
+void ga_udp_server::set_tick_rate(int ticks_per_second)
+{
+	_tick_poller.set_tick_interval(std::chrono::microseconds(1000000 / ticks_per_second));
+}
+
+bool ga_udp_server::wait_for_tick(int timeout_ms)
+{
+	// Sleep until the next tick, handling commands as they arrive
+	for (;;)
+	{
+		int events = _tick_poller.wait(timeout_ms);
+		if (events & k_poll_notified)
+		{
+			receive_commands();
+		}
+		if (events & k_poll_tick)
+		{
+			return true;
+		}
+		if (events == 0)
+		{
+			return false;
+		}
+	}
+}
+
+void ga_udp_server::receive_commands()
+{
+	// Handle commands the network thread has received since last call
+	ga_packet* received;
+	while (_network->pop_inbound(&received))
+	{
+		ga_packet_ref packet(_pool, received);
+		handle_packet(packet.get());
+	}
+}
+
 void ga_udp_server::update(ga_frame_params * params)
 {
-	// Receive commands from clients
-	ga_address sender;
-	char* buffer = receive_data(sender);
-	while (buffer != NULL)
+	// Timeouts, send rates and packet times all run on the frame's clock
+	_tick_time = params->_current_time;
+	receive_commands();
+	drop_timed_out_clients();
+
+	// Master gamestate is ready, capture it once into the shared history
+	ga_snapshot& snapshot = _history[_snapshot_offset];
+	for (int e = 0; e < (int)_entities.size(); e++)
 	{
-		// Handle command in buffer
-		handle_command(buffer, sender);
-		// Get next command
-		delete buffer; // Free up the buffer from memory
-		buffer = receive_data(sender); // Read next packet
+		if (_entities[e])
+		{
+			snapshot.add_entity(e, *_entities[e]);
+		}
+		else
+		{
+			snapshot.remove_entity(e);
+		}
 	}
+	_history_sequences[_snapshot_offset] = _snapshot_sequence;
 
-	// Master gamestate is ready, time to update snapshots
-	for (int c = 0; c < _clients.size(); c++)
+	// Positions feed both send priorities and area of interest queries
+	_previous_positions.swap(_positions);
+	_positions.resize(_entities.size());
+	for (int e = 0; e < (int)_entities.size(); e++)
 	{
-		_client_snapshots[c][_snapshot_offset] = ga_snapshot(_sim->num_entities());
-		for (int e = 0; e < _sim->num_entities(); e++) 
+		if (_entities[e])
 		{
-			_client_snapshots[c][_snapshot_offset].add_entity(e,*(_sim->get_entity(e)));
+			_positions[e] = _entities[e]->get_transform().get_translation();
 		}
 	}
+	if (_previous_positions.size() != _positions.size())
+	{
+		_previous_positions = _positions;
+	}
+	if (_interest_radius > 0.0f)
+	{
+		_grid.build(_positions.data(), (int)_positions.size(), _interest_radius);
+	}
 	// Send snapshots to clients
+	auto start = std::chrono::high_resolution_clock::now();
 	send_snapshots();
+	_send_ms.add(std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+
+	if (_stats_interval.count() > 0 && _tick_time - _last_stats >= _stats_interval)
+	{
+		print_stats();
+		_last_stats = _tick_time;
+	}
+}
+
+void ga_udp_server::set_stats_interval(std::chrono::milliseconds interval)
+{
+	_stats_interval = interval;
+}
+
+bool ga_udp_server::send_message(int client, const void* data, int size)
+{
+	return _clients[client] && _clients[client]->_channel.send(data, size);
+}
+
+bool ga_udp_server::receive_message(int client, std::vector<uint8_t>* message)
+{
+	return _clients[client] && _clients[client]->_channel.receive(message);
+}
+
+const ga_network_stats* ga_udp_server::get_client_stats(int client) const
+{
+	return _clients[client] ? &_clients[client]->_stats : NULL;
+}
+
+const ga_send_rate* ga_udp_server::get_client_send_rate(int client) const
+{
+	return _clients[client] ? &_clients[client]->_rate : NULL;
+}
+
+const ga_rolling_stat& ga_udp_server::get_full_snapshot_bytes() const
+{
+	return _full_snapshot_bytes;
+}
+
+const ga_rolling_stat& ga_udp_server::get_send_ms() const
+{
+	return _send_ms;
+}
+
+void ga_udp_server::print_stats()
+{
+	printf("server: %d clients, send %.2f ms (max %.2f), full snapshot %.0f B\n",
+		_client_table->get_client_count(),
+		_send_ms.get_mean(),
+		_send_ms.get_max(),
+		_full_snapshot_bytes.get_mean());
+	for (int c = 0; c < (int)_clients.size(); c++)
+	{
+		if (!_clients[c])
+		{
+			continue;
+		}
+		const ga_address& address = _clients[c]->_address;
+		const ga_send_rate& rate = _clients[c]->_rate;
+		char name[128];
+		snprintf(name, sizeof(name), "client %d %d.%d.%d.%d:%d (every %d ticks, budget %.0f%%)", c,
+			(address.get_address() >> 24) & 0xff, (address.get_address() >> 16) & 0xff,
+			(address.get_address() >> 8) & 0xff, address.get_address() & 0xff, address.get_port(),
+			rate.get_send_interval(), rate.get_budget_scale() * 100.0f);
+		ga_print_network_stats(name, _clients[c]->_stats);
+	}
 }
 
 void ga_udp_server::send_snapshots()
 {
-	for (int c = 0; c < _clients.size(); c++)
+	// Deltas encoded last tick are stale now
+	for (int i = 0; i <= MAX_SNAPSHOTS; i++)
 	{
-		send_snapshot(c);
+		_delta_cache[i]._baseline = k_invalid_baseline;
 	}
+
+	// Clients that see everything share one encoding per baseline, so find
+	// which baselines are needed and encode those first. The one against
+	// nothing is always encoded, its size is the full snapshot size.
+	// Clients on congested links skip some ticks
+	int client_count = 0;
+	int shared_count = 1;
+	auto clients = static_cast<int*>(alloca(sizeof(int) * _clients.size()));
+	auto shared = static_cast<int*>(alloca(sizeof(int) * (MAX_SNAPSHOTS + 1)));
+	shared[0] = -1;
+	_delta_cache[get_cache_slot(-1)]._baseline = -1;
+	for (int c = 0; c < (int)_clients.size(); c++)
+	{
+		if (!_clients[c])
+		{
+			continue;
+		}
+		if (_adaptive_rate)
+		{
+			_clients[c]->_rate.update(_clients[c]->_stats, _tick_time);
+			if (!_clients[c]->_rate.tick())
+			{
+				continue;
+			}
+		}
+		clients[client_count++] = c;
+		int baseline = get_baseline(_clients[c]);
+		_clients[c]->_baseline = baseline;
+		bool everything = _interest_radius <= 0.0f || get_player(c) == NO_PLAYER_ENTITY;
+		ga_delta_cache_entry& entry = _delta_cache[get_cache_slot(baseline)];
+		if (everything && entry._baseline != baseline)
+		{
+			entry._baseline = baseline;
+			shared[shared_count++] = baseline;
+		}
+	}
+
+	struct encode_data_t
+	{
+		ga_udp_server* _server;
+		int _index;
+	};
+	int job_count = shared_count > client_count ? shared_count : client_count;
+	auto decls = static_cast<ga_job_decl_t*>(alloca(sizeof(ga_job_decl_t) * job_count));
+	auto encode_data = static_cast<encode_data_t*>(alloca(sizeof(encode_data_t) * job_count));
+
+	for (int i = 0; i < shared_count; i++)
+	{
+		encode_data[i]._server = this;
+		encode_data[i]._index = shared[i];
+
+		decls[i]._data = encode_data + i;
+		decls[i]._entry = [](void* data)
+		{
+			auto encode_data = static_cast<encode_data_t*>(data);
+			ga_udp_server* server = encode_data->_server;
+			int baseline = encode_data->_index;
+			server->write_delta(baseline, NULL, NULL, NULL, &server->_delta_cache[get_cache_slot(baseline)]);
+		};
+	}
+	int32_t shared_counter;
+	ga_job::run(decls, shared_count, &shared_counter);
+	ga_job::wait(&shared_counter);
+	_full_snapshot_bytes.add((float)_delta_cache[get_cache_slot(-1)]._size);
+
+	// Each client's snapshot is encoded and split into packets by its own job
+	for (int i = 0; i < client_count; i++)
+	{
+		encode_data[i]._server = this;
+		encode_data[i]._index = clients[i];
+
+		decls[i]._data = encode_data + i;
+		decls[i]._entry = [](void* data)
+		{
+			auto encode_data = static_cast<encode_data_t*>(data);
+			encode_data->_server->send_snapshot(encode_data->_index);
+		};
+	}
+	if (client_count > 0)
+	{
+		int32_t client_counter;
+		ga_job::run(decls, client_count, &client_counter);
+		ga_job::wait(&client_counter);
+	}
+
+	// Hand every client's packets to the network thread in one batch
+	for (int i = 0; i < client_count; i++)
+	{
+		std::vector<ga_packet*>& outbound = _clients[clients[i]]->_outbound;
+		for (int p = 0; p < (int)outbound.size(); p++)
+		{
+			_network->push_outbound(outbound[p]);
+		}
+		outbound.clear();
+	}
+	_network->flush();
 	_snapshot_offset = (_snapshot_offset + 1) % MAX_SNAPSHOTS;
+	_snapshot_sequence++;
+}
+
+int ga_udp_server::send_snapshot(int c)
+{
+	// Runs as a job; only touches this client's state and reads the rest
+	auto start = std::chrono::high_resolution_clock::now();
+	ga_server_client* client = _clients[c];
+	int baseline = client->_baseline;
+	uint16_t player = get_player(c);
+	bool everything = update_relevance(client, player);
+
+	// Entities that came into view since the baseline are sent in full, the
+	// client's copy of them is out of date. Those the client holds that went
+	// out of view are sent as removals, so it stops showing them
+	bool entered = false;
+	const ga_snapshot& source = baseline == -1 ? _dummy : _history[baseline];
+	const ga_snapshot& curr = _history[_snapshot_offset];
+	std::vector<uint64_t>& relevant = client->_relevant[_snapshot_offset];
+	std::vector<uint64_t>& entering = client->_entered;
+	std::vector<uint64_t>& left = client->_left;
+	entering.assign(relevant.size(), 0);
+	left.assign(relevant.size(), 0);
+	if (baseline != -1)
+	{
+		const std::vector<uint64_t>& previous = client->_relevant[baseline];
+		const std::vector<uint64_t>& held = client->_held[baseline];
+		for (size_t b = 0; b < relevant.size(); b++)
+		{
+			entering[b] = relevant[b] & ~(b < previous.size() ? previous[b] : 0) & curr.get_live_block(b);
+			left[b] = (b < held.size() ? held[b] : 0) & ~relevant[b] & curr.get_live_block(b);
+			entered = entered || entering[b] != 0;
+		}
+	}
+
+	// Unchanged snapshots are still sent: they keep the client's
+	// interpolation timeline moving and cost only a few bytes
+	const ga_delta_cache_entry* delta = &client->_delta;
+	if (everything && !entered)
+	{
+		delta = &_delta_cache[get_cache_slot(baseline)];
+	}
+	else
+	{
+		write_delta(baseline, relevant.data(), entering.data(), left.data(), &client->_delta);
+	}
+
+	// Over budget, send what matters most now and carry the rest over
+	int budget = get_delta_capacity();
+	if (_snapshot_budget > 0 && _snapshot_budget < budget)
+	{
+		budget = _snapshot_budget;
+	}
+	if (_adaptive_rate && client->_rate.get_budget_scale() < 1.0f)
+	{
+		// Never less than one fragment
+		int fragment = _mtu - PACKET_HEADER_SIZE - SNAPSHOT_INFO_SIZE - RELIABLE_HEADER_SIZE - FRAGMENT_HEADER_SIZE;
+		budget = (int)(budget * client->_rate.get_budget_scale());
+		budget = budget > fragment ? budget : fragment;
+	}
+	if (delta->_size == 0 || delta->_size > budget)
+	{
+		prioritize(client, baseline, player, budget);
+		delta = &client->_delta;
+		write_delta(baseline, relevant.data(), entering.data(), left.data(), &client->_delta);
+	}
+	else
+	{
+		client->_priority.clear();
+	}
+	// The client's copy keeps what it held unless this snapshot removes it,
+	// and holds whatever this snapshot sends
+	const std::vector<uint64_t>* base = baseline != -1 ? &client->_held[baseline] : NULL;
+	std::vector<uint64_t>& held = client->_held[_snapshot_offset];
+	held.resize(relevant.size());
+	client->_sent_full.resize(relevant.size());
+	for (size_t b = 0; b < relevant.size(); b++)
+	{
+		uint64_t live = curr.get_live_block(b);
+		uint64_t full = relevant[b] & live & (entering[b] | ~source.get_live_block(b));
+		uint64_t changed = ga_snapshot::compare_block(source, curr, (int)b) & relevant[b];
+		uint64_t kept = base && b < base->size() ? (*base)[b] & ~left[b] : 0;
+		held[b] = (kept | changed | full) & live;
+		client->_sent_full[b] = full;
+	}
+	auto now = _tick_time;
+	client->_stats._snapshot_us.add(std::chrono::duration<float, std::micro>(std::chrono::high_resolution_clock::now() - start).count());
+	int fragment_mtu = _mtu - PACKET_HEADER_SIZE - SNAPSHOT_INFO_SIZE - RELIABLE_HEADER_SIZE;
+	int fragment_size = fragment_mtu - FRAGMENT_HEADER_SIZE;
+	int count = 0;
+	ga_packet_ref fragments[MAX_FRAGMENTS];
+	if (delta->_size > 0)
+	{
+		client->_stats._snapshot_bytes.add((float)delta->_size);
+		count = ga_fragment_count(delta->_size, fragment_mtu);
+	}
+	// Take every fragment's packet up front. A snapshot the pool cannot send
+	// whole is not sent at all, it could never be acked as a baseline
+	for (int f = 0; f < count; f++)
+	{
+		fragments[f] = ga_packet_ref(_pool);
+		if (!fragments[f])
+		{
+			for (int i = 0; i < f; i++)
+			{
+				fragments[i].reset();
+			}
+			count = 0;
+			break;
+		}
+	}
+	client->_unacked_fragments[_snapshot_offset] = count;
+
+	// Split into MTU sized fragments, each in its own acked packet. Reliable
+	// messages fill the room left over, then any still due get packets of
+	// their own
+	const unsigned char* payload = delta->_data.data();
+	float resend_ms = client->_stats.get_rtt_timeout_ms();
+	int sent = 0;
+	for (int f = 0; f < count || client->_channel.has_due(now, resend_ms); f++)
+	{
+		bool fragment = f < count;
+		ga_packet_ref packet = fragment ? std::move(fragments[f]) : ga_packet_ref(_pool);
+		if (!packet)
+		{
+			break;
+		}
+		int fragment_bytes = 0;
+		if (fragment)
+		{
+			int length = delta->_size - f * fragment_size;
+			fragment_bytes = FRAGMENT_HEADER_SIZE + (length < fragment_size ? length : fragment_size);
+		}
+		ga_packet_header header;
+		client->_acks.prepare_header(&header);
+		client->_packet_snapshots[header._sequence % ACK_HISTORY_SIZE] = fragment ? _snapshot_sequence : -1;
+		packet->_address = client->_address;
+		packet->_size = ga_write_packet_header(header, packet->_data);
+		ga_bit_writer info(packet->_data + packet->_size, SNAPSHOT_INFO_SIZE);
+		info.write_bits(client->_last_input, 16);
+		info.write_bits(player, 16);
+		packet->_size += SNAPSHOT_INFO_SIZE;
+		int block = client->_channel.write(header._sequence, now, resend_ms, packet->_data + packet->_size, _mtu - packet->_size - fragment_bytes);
+		packet->_size += block;
+		if (fragment)
+		{
+			packet->_size += ga_write_fragment(_snapshot_sequence, payload, delta->_size, f, fragment_mtu, packet->_data + packet->_size);
+		}
+		else if (block == RELIABLE_HEADER_SIZE)
+		{
+			// What is due does not fit in a packet at this MTU
+			break;
+		}
+		sent += packet->_size;
+		client->_stats.on_packet_sent(header._sequence, packet->_size, now);
+		client->_outbound.push_back(packet.release());
+	}
+	return sent;
 }
 
-char* ga_udp_server::receive_data(ga_address& sender)
+int ga_udp_server::get_baseline(const ga_server_client* client) const
 {
-	char* buffer = new char[MAX_BUFFER];
-	int read = _socket->receive(sender, buffer, MAX_BUFFER);
-	if (read == 0)
+	// The last snapshot this client acked, or -1 for the dummy if none yet
+	// or if the history ring has since overwritten it
+	int acked = client->_acked_sequence;
+	if (acked != -1 && (uint16_t)(_snapshot_sequence - acked) < MAX_SNAPSHOTS)
 	{
-		return NULL;
+		return acked % MAX_SNAPSHOTS;
 	}
-	buffer[read] = '\0';
-	return buffer;
+	return -1;
 }
 
-int ga_udp_server::send_snapshot(int client)
+int ga_udp_server::get_cache_slot(int baseline)
 {
-	char to_send[MAX_BUFFER];
-	// Write stuff to to_send
-	ga_snapshot source, curr;
-	if (_prev_states[client] == -1)
+	return baseline == -1 ? MAX_SNAPSHOTS : baseline;
+}
+
+bool ga_udp_server::update_relevance(ga_server_client* client, uint16_t player)
+{
+	// Returns true if every entity is relevant to this client. Ids that
+	// are not live may be relevant too, diffs skip them
+	std::vector<uint64_t>& relevant = client->_relevant[_snapshot_offset];
+	if (_interest_radius > 0.0f && player != NO_PLAYER_ENTITY)
 	{
-		source = _dummy;
+		relevant.assign(_dummy.num_blocks(), 0);
+		_grid.query(_positions[player], _interest_radius, relevant.data());
+		return false;
 	}
-	else {
-		source = _client_snapshots[client][_prev_states[client]];
+	relevant.assign(_dummy.num_blocks(), ~0ull);
+	return true;
+}
+
+void ga_udp_server::prioritize(ga_server_client* client, int baseline, uint16_t player, int budget)
+{
+	// Keep the highest priority entities that fit in budget bytes in this
+	// snapshot's relevant mask and drop the others from it. Dropped entities
+	// are then missing from the client's copy, so are later sent in full
+	std::vector<uint64_t>& relevant = client->_relevant[_snapshot_offset];
+	std::vector<float>& priority = client->_priority;
+	std::vector<uint64_t>& entered = client->_entered;
+	const std::vector<uint64_t>& left = client->_left;
+	std::vector<int>& candidates = client->_candidates;
+	const ga_snapshot& source = baseline == -1 ? _dummy : _history[baseline];
+	const ga_snapshot& curr = _history[_snapshot_offset];
+	priority.resize(_dummy.num_entities(), 0.0f);
+
+	// Gaps between sent indices are bounded by the entity count
+	int gap_bits = 8;
+	for (int n = _dummy.num_entities() >> 7; n != 0; n >>= 7)
+	{
+		gap_bits += 8;
 	}
-	curr = _client_snapshots[client][_snapshot_offset];
-	itoa(_snapshot_offset, to_send, 10);
-	strcat(to_send, std::string(" ").c_str());
-	char* diff = ga_snapshot::diff(source, curr);
-	if (strlen(diff) == 0)
+	// Leave room for the two snapshot offsets and the list terminator, and
+	// for what is always sent: removals, including of entities that went out
+	// of view, and entities the last snapshot sent in full that the baseline
+	// still lacks, which would otherwise vanish from the client again
+	int remaining = budget * 8 - 17;
+	candidates.clear();
+	for (int block = 0; block < (int)relevant.size(); block++)
 	{
-		return 0;
+		uint64_t changed = ga_snapshot::compare_block(source, curr, block);
+		uint64_t live = curr.get_live_block(block);
+		uint64_t full = block < (int)client->_sent_full.size() ? client->_sent_full[block] : 0;
+		full &= relevant[block] & live & (entered[block] | ~source.get_live_block(block));
+		uint64_t required = (changed & ~live) | full;
+		for (int bit = 0; required != 0; bit++, required >>= 1)
+		{
+			if (required & 1)
+			{
+				bool absolute = (entered[block] >> bit) & 1;
+				remaining -= gap_bits + ga_snapshot::entity_bits(source, curr, block * 64 + bit, absolute);
+			}
+		}
+		for (uint64_t gone = left[block]; gone != 0; gone &= gone - 1)
+		{
+			remaining -= gap_bits + 1 + k_field_count;
+		}
+		uint64_t pending = ((changed & relevant[block]) | entered[block]) & live & ~full;
+		for (int bit = 0; pending != 0; bit++, pending >>= 1)
+		{
+			if ((pending & 1) == 0)
+			{
+				continue;
+			}
+			int e = block * 64 + bit;
+			float speed = _positions[e].dist(_previous_positions[e]);
+			float distance = player != NO_PLAYER_ENTITY ? _positions[e].dist(_positions[player]) : 0.0f;
+			priority[e] += (1.0f + speed * k_speed_priority) / (1.0f + distance * k_distance_priority);
+			candidates.push_back(e);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [&priority](int a, int b)
+	{
+		return priority[a] > priority[b] || (priority[a] == priority[b] && a < b);
+	});
+
+	for (int i = 0; i < (int)candidates.size(); i++)
+	{
+		int e = candidates[i];
+		uint64_t bit = 1ull << (e & 63);
+		bool absolute = (entered[e >> 6] & bit) != 0;
+		int bits = gap_bits + ga_snapshot::entity_bits(source, curr, e, absolute);
+		if (bits <= remaining)
+		{
+			remaining -= bits;
+			priority[e] = 0.0f;
+		}
+		else
+		{
+			relevant[e >> 6] &= ~bit;
+			entered[e >> 6] &= ~bit;
+		}
 	}
-	strcat(to_send,ga_snapshot::diff(source, curr));
-	int sent = _socket->send(_clients.at(client), to_send, strlen(to_send));
-	return sent;
 }
 
+int ga_udp_server::get_delta_capacity() const
+{
+	return MAX_FRAGMENTS * (_mtu - PACKET_HEADER_SIZE - SNAPSHOT_INFO_SIZE - RELIABLE_HEADER_SIZE - FRAGMENT_HEADER_SIZE);
+}
+
+void ga_udp_server::write_delta(int baseline, const uint64_t* relevant, const uint64_t* entered, const uint64_t* left, ga_delta_cache_entry* entry)
+{
+	entry->_baseline = baseline;
+	entry->_size = 0;
+
+	// Entries keep their buffer and only grow it, up to the capacity, when
+	// a delta does not fit
+	const ga_snapshot& source = baseline == -1 ? _dummy : _history[baseline];
+	const ga_snapshot& curr = _history[_snapshot_offset];
+	int capacity = get_delta_capacity();
+	if (entry->_data.empty())
+	{
+		entry->_data.resize(_mtu < capacity ? _mtu : capacity);
+	}
+	for (;;)
+	{
+		int size = (int)entry->_data.size() < capacity ? (int)entry->_data.size() : capacity;
+		ga_bit_writer writer(entry->_data.data(), size);
+		writer.write_bits(_snapshot_offset, 8);
+		writer.write_bits(baseline == -1 ? NO_BASELINE : baseline, 8);
+		ga_snapshot::diff(source, curr, &writer, relevant, entered, left);
+		if (!writer.overflowed())
+		{
+			entry->_size = writer.get_bytes_written();
+			return;
+		}
+		if (size >= capacity)
+		{
+			return;
+		}
+		entry->_data.resize(size * 2 < capacity ? size * 2 : capacity);
+	}
+}
@@ -1,34 +1,204 @@
 #pragma once
 #include "ga_socket.h"
+#include "ga_fragment.h"
+#include "ga_packet_header.h"
+#include "ga_input_command.h"
+#include "ga_packet_pool.h"
+#include "ga_client_table.h"
+#include "ga_spatial_grid.h"
+#include "ga_network_thread.h"
+#include "ga_network_stats.h"
+#include "ga_send_rate.h"
+#include "ga_reliable_channel.h"
 #include "framework/ga_snapshot.h"
 #include "framework/ga_frame_params.h"
 #include "framework/ga_sim.h"
 
-#define MAX_SNAPSHOTS 32
+#include <deque>
+
+#define MAX_CLIENTS 512
+#define CLIENT_TIMEOUT_MS 5000
+#define SERVER_PACKET_POOL_SIZE (2 * MAX_CLIENTS + 4 * SOCKET_BATCH_SIZE)
+
+/*
+** Hands each client the entity it controls when it connects, and takes it
+** back once the client disconnects or times out. It may spawn a new entity
+** with add_entity or hand out one already networked.
+*/
+class ga_player_factory
+{
+public:
+	virtual ~ga_player_factory() {}
+
+	// The network id of the client's entity, or NO_PLAYER_ENTITY for none.
+	virtual uint16_t spawn(int client) = 0;
+	virtual void despawn(int client, uint16_t id) = 0;
+};
+
+/*
+** An encoded delta between a baseline and the current snapshot.
+** Every client acked on the same baseline is sent the same bytes.
+*/
+struct ga_delta_cache_entry
+{
+	int _baseline;
+	std::vector<unsigned char> _data;
+	int _size;
+};
+
+/*
+** Per-client connection state.
+** _player is the network id of the entity this client controls.
+** A snapshot counts as acked once every fragment packet carrying it is.
+** _packet_snapshots is -1 for packets that only carried reliable messages.
+** _relevant holds, per history slot, which entities that snapshot carried
+** to this client, and _held which ones the client's copy of it has live. _priority accumulates for entities held back by the
+** snapshot budget until they are sent. _rate slows sending down while the
+** client's link is congested. The rest is scratch for the job
+** encoding this client's snapshot, which leaves its packets in _outbound.
+*/
+struct ga_server_client
+{
+	ga_address _address;
+	std::chrono::high_resolution_clock::time_point _last_received;
+	ga_ack_tracker _acks;
+	int _acked_sequence;
+	uint16_t _last_input;
+	uint16_t _player;
+	int _packet_snapshots[ACK_HISTORY_SIZE];
+	int _unacked_fragments[MAX_SNAPSHOTS];
+	std::vector<uint64_t> _relevant[MAX_SNAPSHOTS];
+	std::vector<uint64_t> _held[MAX_SNAPSHOTS];
+	std::vector<float> _priority;
+	ga_network_stats _stats;
+	ga_send_rate _rate;
+	ga_reliable_channel _channel;
+	int _baseline;
+	ga_delta_cache_entry _delta;
+	std::vector<uint64_t> _entered;
+	std::vector<uint64_t> _left;
+	std::vector<uint64_t> _sent_full;
+	std::vector<int> _candidates;
+	std::vector<ga_packet*> _outbound;
+};
 
-typedef std::vector<ga_snapshot> snapshot_array;
 class ga_udp_server
 {
 public:
 	ga_udp_server(short port, ga_sim* sim);
+
+	// Runs over a transport the caller owns, such as a loopback one
+	ga_udp_server(ga_transport* transport, ga_sim* sim);
 	~ga_udp_server();
+
+	// Networks an entity the caller owns and returns the id clients know it
+	// by, or -1 if every id is taken. Entities already in the sim passed to
+	// the constructor are added in order, so their id is their index.
+	int add_entity(ga_entity* entity);
+
+	// Clients remove their copy of the entity. Its id is only reused once
+	// no snapshot a client could diff against still has it in.
+	void remove_entity(uint16_t id);
+	ga_entity* get_entity(uint16_t id) const;
+
+	// Without a factory, clients control no entity. The factory must outlive
+	// the server, and should be set before the first update.
+	void set_player_factory(ga_player_factory* factory);
+
 	bool initialize_sockets();
 	void shutdown_sockets();
 	void update(struct ga_frame_params* params);
+	void set_mtu(int mtu);
+	void set_tick_rate(int ticks_per_second);
+
+	// Clients only receive entities within this distance of the one they
+	// control. Zero, the default, sends everything.
+	void set_interest_radius(float radius);
+
+	// Upper bound on the encoded snapshot each client is sent per tick, in
+	// bytes. Zero, the default, allows as much as fits in MAX_FRAGMENTS.
+	void set_snapshot_budget(int bytes);
+
+	// Whether clients on congested links are sent less, see ga_send_rate.
+	// On by default.
+	void set_adaptive_rate(bool enabled);
+	bool wait_for_tick(int timeout_ms);
+
+	// Queues a message for a client, delivered reliably and in order
+	// alongside its snapshots. False if no client is connected in that slot
+	// or its queue is full, see ga_reliable_channel.
+	bool send_message(int client, const void* data, int size);
+
+	// Pops the next message a client sent, in order.
+	bool receive_message(int client, std::vector<uint8_t>* message);
+
+	// Prints every client's stats this often. Zero, the default, never does.
+	void set_stats_interval(std::chrono::milliseconds interval);
+
+	// NULL if no client is connected in that slot.
+	const ga_network_stats* get_client_stats(int client) const;
+	const ga_send_rate* get_client_send_rate(int client) const;
+
+	// Size of the current snapshot diffed against nothing, and the time
+	// spent encoding and queueing every client's snapshot, per tick.
+	const ga_rolling_stat& get_full_snapshot_bytes() const;
+	const ga_rolling_stat& get_send_ms() const;
 
 private:
+	void initialize(ga_transport* transport, ga_sim* sim);
+	uint16_t get_player(int client) const;
+	void receive_commands();
 	void send_snapshots();
 	int send_snapshot(int client);
-	char* receive_data(ga_address& sender);
-	void handle_command(char * buffer, ga_address sender);
+	bool update_relevance(ga_server_client* client, uint16_t player);
+	void prioritize(ga_server_client* client, int baseline, uint16_t player, int budget);
+	int get_delta_capacity() const;
+	int get_baseline(const ga_server_client* client) const;
+	static int get_cache_slot(int baseline);
+	void write_delta(int baseline, const uint64_t* relevant, const uint64_t* entered, const uint64_t* left, ga_delta_cache_entry* entry);
+	void handle_packet(ga_packet* packet);
+	void handle_message(const uint8_t* body, int size, int client);
+	void handle_ack(ga_server_client* client, uint16_t packet_sequence);
+	void drop_client(int client);
+	void drop_timed_out_clients();
+	void print_stats();
 
 
 	// Representation
 	ga_socket* _socket;
 	ga_sim* _sim;
+	ga_player_factory* _player_factory;
+
+	// Networked entities by id, NULL where the id is free. Freed ids wait
+	// in order, with the snapshot sequence they were freed on
+	struct freed_id_t
+	{
+		uint16_t _id;
+		uint16_t _sequence;
+	};
+	std::vector<ga_entity*> _entities;
+	std::deque<freed_id_t> _freed_ids;
 	ga_snapshot _dummy;
-	std::vector<snapshot_array> _client_snapshots;
-	std::vector<ga_address> _clients;
-	std::vector<int> _prev_states;
+	std::vector<ga_snapshot> _history;
+	std::vector<uint16_t> _history_sequences;
+	ga_client_table* _client_table;
+	std::vector<ga_server_client*> _clients;
+	ga_delta_cache_entry _delta_cache[MAX_SNAPSHOTS + 1];
 	int _snapshot_offset;
+	uint16_t _snapshot_sequence;
+	int _mtu;
+	float _interest_radius;
+	int _snapshot_budget;
+	bool _adaptive_rate;
+	ga_spatial_grid _grid;
+	std::vector<ga_vec3f> _positions;
+	std::vector<ga_vec3f> _previous_positions;
+	ga_rolling_stat _full_snapshot_bytes;
+	ga_rolling_stat _send_ms;
+	std::chrono::milliseconds _stats_interval;
+	std::chrono::high_resolution_clock::time_point _last_stats;
+	std::chrono::high_resolution_clock::time_point _tick_time;
+	ga_packet_pool* _pool;
+	ga_network_thread* _network;
+	ga_poller _tick_poller;
 };
\ No newline at end of file
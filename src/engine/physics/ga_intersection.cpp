@@ -12,6 +12,7 @@
 #include "ga_shape.h"
 
 #include <cassert>
+#include <climits>
 #include <float.h>
 #include <vector>
 
@@ -10,6 +10,7 @@
 #include "ga_physics_component.h"
 #include "ga_physics_world.h"
 #include "ga_rigid_body.h"
+#include "ga_shape.h"
 
 #include "entity/ga_entity.h"
 
@@ -29,19 +30,23 @@ void ga_physics_component::update(ga_frame_params* params)
 {
 	// First, re-sync the rigid body's transform with the entity's.
 	_body->_transform = get_entity()->get_transform();
+}
+
+void ga_physics_component::late_update(ga_frame_params* params)
+{
+	// Sync the entity's transform with the rigid body's.
+	get_entity()->set_transform(_body->_transform);
+}
 
+void ga_physics_component::draw(ga_frame_params* params)
+{
 #if GA_PHYSICS_DEBUG_DRAW
+	// Drawn where the entity is shown, leaving the body at its tick state
 	ga_dynamic_drawcall draw;
-	_body->get_debug_draw(&draw);
+	_body->_shape->get_debug_draw(get_entity()->get_transform(), &draw);
 
 	while (params->_dynamic_drawcall_lock.test_and_set(std::memory_order_acquire)) {}
 	params->_dynamic_drawcalls.push_back(draw);
 	params->_dynamic_drawcall_lock.clear(std::memory_order_release);
 #endif
 }
-
-void ga_physics_component::late_update(ga_frame_params* params)
-{
-	// Sync the entity's transform with the rigid body's.
-	get_entity()->set_transform(_body->_transform);
-}
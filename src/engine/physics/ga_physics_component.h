@@ -23,6 +23,7 @@ public:
 
 	virtual void update(struct ga_frame_params* params) override;
 	virtual void late_update(struct ga_frame_params* params) override;
+	virtual void draw(struct ga_frame_params* params) override;
 
 	class ga_rigid_body* get_rigid_body() const { return _body; }
 
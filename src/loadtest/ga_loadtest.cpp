@@ -0,0 +1,391 @@
+/*
+** Headless load generator for ga_udp_server.
+**
+** Runs a server and hundreds of bot clients in one process. Bots are plain
+** ga_udp_clients driven from a few threads: they connect, send random
+** inputs, decode snapshots and ack them. Traffic goes over a simulated
+** loopback network, or real UDP sockets on localhost with "udp".
+**
+** Usage: ga_loadtest <clients> <seconds> [threads] [latency_ms] [loss_percent] [udp]
+*/
+
+#include "framework/ga_frame_params.h"
+#include "framework/ga_sim.h"
+#include "jobs/ga_job.h"
+
+#include "entity/ga_entity.h"
+
+#include "network/ga_bitstream.h"
+#include "network/ga_loopback.h"
+#include "network/ga_udp_client.h"
+#include "network/ga_udp_server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+char g_root_path[256];
+
+static const int k_tick_rate = 60;
+static const unsigned short k_server_port = 9000;
+static const unsigned short k_bot_port = 10000;
+
+static const std::chrono::high_resolution_clock::duration k_tick_interval =
+	std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+		std::chrono::microseconds(1000000 / k_tick_rate));
+
+// When the server started encoding each snapshot sequence, in clock ticks
+static std::atomic<int64_t> g_snapshot_times[65536];
+
+/*
+** Wraps a bot's transport to count its traffic, time how long snapshots
+** take to arrive and how long the bot takes to ack what it receives.
+*/
+class ga_bot_transport : public ga_transport
+{
+public:
+	ga_bot_transport(ga_transport* transport)
+	{
+		_transport = transport;
+		_bytes_in = 0;
+		_bytes_out = 0;
+		_last_ack = 0xffff;
+		for (int i = 0; i < ACK_HISTORY_SIZE; i++)
+		{
+			_received[i]._valid = false;
+		}
+	}
+
+	virtual int send_batch(ga_packet* const* packets, int count) override
+	{
+		auto now = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < count; i++)
+		{
+			_bytes_out += packets[i]->_size;
+			ga_packet_header header;
+			if (!ga_read_packet_header(packets[i]->_data, packets[i]->_size, &header) || header._ack == _last_ack)
+			{
+				continue;
+			}
+			_last_ack = header._ack;
+			const received_t& received = _received[header._ack % ACK_HISTORY_SIZE];
+			if (received._valid && received._sequence == header._ack)
+			{
+				_ack_lag_ms.push_back(std::chrono::duration<float, std::milli>(now - received._time).count());
+			}
+		}
+		return _transport->send_batch(packets, count);
+	}
+
+	virtual int receive_batch(ga_packet* const* packets, int count) override
+	{
+		count = _transport->receive_batch(packets, count);
+		for (int i = 0; i < count; i++)
+		{
+			const ga_packet* packet = packets[i];
+			_bytes_in += packet->_size;
+			ga_packet_header header;
+			int offset = PACKET_HEADER_SIZE + SNAPSHOT_INFO_SIZE;
+			if (!ga_read_packet_header(packet->_data, packet->_size, &header) || packet->_size < offset + RELIABLE_HEADER_SIZE)
+			{
+				continue;
+			}
+			int block = ga_reliable_channel::get_block_size(packet->_data + offset, packet->_size - offset);
+			offset += block;
+			if (block < 0 || packet->_size < offset + FRAGMENT_HEADER_SIZE)
+			{
+				continue;
+			}
+			received_t& received = _received[header._sequence % ACK_HISTORY_SIZE];
+			received._valid = true;
+			received._sequence = header._sequence;
+			received._time = packet->_time;
+
+			ga_bit_reader reader(packet->_data + offset, FRAGMENT_HEADER_SIZE);
+			uint16_t snapshot = (uint16_t)reader.read_bits(16);
+			std::chrono::high_resolution_clock::time_point sent(
+				std::chrono::high_resolution_clock::duration(g_snapshot_times[snapshot].load()));
+			_latency_ms.push_back(std::chrono::duration<float, std::milli>(packet->_time - sent).count());
+		}
+		return count;
+	}
+
+	virtual bool wait(int timeout_ms) override
+	{
+		return _transport->wait(timeout_ms);
+	}
+
+	virtual int get_handle() const override
+	{
+		return _transport->get_handle();
+	}
+
+	int64_t _bytes_in;
+	int64_t _bytes_out;
+	std::vector<float> _latency_ms;
+	std::vector<float> _ack_lag_ms;
+
+private:
+	struct received_t
+	{
+		bool _valid;
+		uint16_t _sequence;
+		std::chrono::high_resolution_clock::time_point _time;
+	};
+
+	ga_transport* _transport;
+	uint16_t _last_ack;
+	received_t _received[ACK_HISTORY_SIZE];
+};
+
+/*
+** One simulated player.
+*/
+struct ga_bot
+{
+	ga_sim _sim;
+	std::vector<ga_entity> _entities;
+	ga_transport* _socket;
+	ga_bot_transport* _transport;
+	ga_udp_client* _client;
+	uint32_t _random;
+	uint32_t _buttons;
+};
+
+/*
+** Spawns a box for each bot as it connects, laid out on a grid by client
+** slot, and removes it once the bot disconnects.
+*/
+class ga_bot_box_factory : public ga_player_factory
+{
+public:
+	ga_bot_box_factory() : _server(NULL), _boxes(MAX_CLIENTS) {}
+
+	uint16_t spawn(int client) override
+	{
+		ga_mat4f transform;
+		transform.make_translation({ (float)(client % 32) * 4.0f, 0.0f, (float)(client / 32) * 4.0f });
+		_boxes[client].set_transform(transform);
+		int id = _server->add_entity(&_boxes[client]);
+		return id == -1 ? NO_PLAYER_ENTITY : (uint16_t)id;
+	}
+
+	void despawn(int, uint16_t id) override
+	{
+		_server->remove_entity(id);
+	}
+
+	ga_udp_server* _server;
+
+private:
+	std::vector<ga_entity> _boxes;
+};
+
+static uint32_t next_random(uint32_t* state);
+static float percentile(std::vector<float>& samples, float fraction);
+static void run_bots(ga_bot** bots, int count, std::atomic_bool* running);
+
+int main(int argc, const char** argv)
+{
+	if (argc < 3)
+	{
+		printf("Usage: ga_loadtest <clients> <seconds> [threads] [latency_ms] [loss_percent] [udp]\n");
+		exit(1);
+	}
+	bool udp = strcmp(argv[argc - 1], "udp") == 0;
+	int args = udp ? argc - 1 : argc;
+	int client_count = atoi(argv[1]);
+	int seconds = atoi(argv[2]);
+	int thread_count = args > 3 ? atoi(argv[3]) : 4;
+	ga_link_conditions conditions;
+	conditions._latency_ms = args > 4 ? atoi(argv[4]) : 0;
+	conditions._loss = args > 5 ? (float)atof(argv[5]) / 100.0f : 0.0f;
+	if (client_count <= 0 || client_count > MAX_CLIENTS || seconds <= 0 || thread_count <= 0)
+	{
+		printf("Expected 1 to %d clients, and a positive duration and thread count\n", MAX_CLIENTS);
+		exit(1);
+	}
+
+	ga_job::startup(0xffff, 256, 256);
+
+	// Every bot controls a box spawned for it when it connects. The loopback
+	// pool holds a few packets per bot for every 10 ms of latency, so latency
+	// alone never drops packets.
+	ga_loopback_network network(1, LOOPBACK_PACKET_POOL_SIZE + client_count * (conditions._latency_ms / 10 + 2) * 4);
+	network.set_conditions(conditions);
+	ga_address server_address(127, 0, 0, 1, k_server_port);
+	ga_sim server_sim;
+	ga_bot_box_factory boxes;
+	ga_loopback_transport* server_transport = udp ? NULL : new ga_loopback_transport(&network, server_address);
+	ga_udp_server* server = udp ? new ga_udp_server(k_server_port, &server_sim) : new ga_udp_server(server_transport, &server_sim);
+	boxes._server = server;
+	server->set_player_factory(&boxes);
+	server->set_tick_rate(k_tick_rate);
+
+	std::vector<ga_bot*> bots(client_count);
+	for (int b = 0; b < client_count; b++)
+	{
+		ga_bot* bot = new ga_bot();
+		bot->_entities.resize(client_count);
+		for (int e = 0; e < client_count; e++)
+		{
+			bot->_sim.add_entity(&bot->_entities[e]);
+		}
+		if (udp)
+		{
+			ga_socket* socket = new ga_socket();
+			socket->open(k_bot_port + b);
+			bot->_socket = socket;
+		}
+		else
+		{
+			bot->_socket = new ga_loopback_transport(&network, ga_address(10, 1, b >> 8, b & 0xff, k_bot_port));
+		}
+		bot->_transport = new ga_bot_transport(bot->_socket);
+		bot->_client = new ga_udp_client(bot->_transport, server_address, &bot->_sim);
+		bot->_client->set_tick_rate(k_tick_rate);
+		bot->_random = b + 1;
+		bot->_buttons = 0;
+		bots[b] = bot;
+	}
+
+	// Bots are split evenly across the threads
+	std::atomic_bool running(true);
+	std::vector<std::thread> threads;
+	int per_thread = (client_count + thread_count - 1) / thread_count;
+	for (int first = 0; first < client_count; first += per_thread)
+	{
+		int count = std::min(per_thread, client_count - first);
+		threads.push_back(std::thread(run_bots, &bots[first], count, &running));
+	}
+
+	// Tick the server on its own clock and time each update
+	std::vector<float> tick_ms;
+	uint16_t sequence = 0;
+	auto end = std::chrono::high_resolution_clock::now() + std::chrono::seconds(seconds);
+	while (std::chrono::high_resolution_clock::now() < end)
+	{
+		if (!server->wait_for_tick(100))
+		{
+			continue;
+		}
+		ga_frame_params params;
+		params._current_time = std::chrono::high_resolution_clock::now();
+		params._delta_time = k_tick_interval;
+		params._button_mask = 0;
+		g_snapshot_times[sequence++] = params._current_time.time_since_epoch().count();
+		server->update(&params);
+		tick_ms.push_back(std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - params._current_time).count());
+	}
+	running = false;
+	for (int t = 0; t < threads.size(); t++)
+	{
+		threads[t].join();
+	}
+
+	// Gather what the bots measured
+	int64_t bytes_in = 0;
+	int64_t bytes_out = 0;
+	std::vector<float> latency_ms;
+	std::vector<float> ack_lag_ms;
+	for (int b = 0; b < client_count; b++)
+	{
+		ga_bot_transport* transport = bots[b]->_transport;
+		bytes_in += transport->_bytes_in;
+		bytes_out += transport->_bytes_out;
+		latency_ms.insert(latency_ms.end(), transport->_latency_ms.begin(), transport->_latency_ms.end());
+		ack_lag_ms.insert(ack_lag_ms.end(), transport->_ack_lag_ms.begin(), transport->_ack_lag_ms.end());
+	}
+	float per_client = 1.0f / ((float)client_count * seconds * 1024.0f);
+	printf("%d clients over %s for %d s, %d bot threads\n", client_count, udp ? "udp" : "loopback", seconds, (int)threads.size());
+	printf("server tick ms:       p50 %.3f  p99 %.3f  max %.3f  (%d ticks)\n",
+		percentile(tick_ms, 0.5f), percentile(tick_ms, 0.99f), percentile(tick_ms, 1.0f), (int)tick_ms.size());
+	printf("per client KB/s:      in %.2f  out %.2f\n", bytes_in * per_client, bytes_out * per_client);
+	printf("snapshot latency ms:  p50 %.2f  p95 %.2f  p99 %.2f\n",
+		percentile(latency_ms, 0.5f), percentile(latency_ms, 0.95f), percentile(latency_ms, 0.99f));
+	printf("ack lag ms:           p50 %.2f  p95 %.2f  p99 %.2f\n",
+		percentile(ack_lag_ms, 0.5f), percentile(ack_lag_ms, 0.95f), percentile(ack_lag_ms, 0.99f));
+
+	// Where the server's rate control left each client
+	int connected = 0;
+	float interval = 0.0f;
+	float budget = 0.0f;
+	for (int c = 0; c < MAX_CLIENTS; c++)
+	{
+		const ga_send_rate* rate = server->get_client_send_rate(c);
+		if (rate)
+		{
+			connected++;
+			interval += rate->get_send_interval();
+			budget += rate->get_budget_scale();
+		}
+	}
+	if (connected > 0)
+	{
+		printf("send rate:            every %.2f ticks  budget %.0f%%  (%d connected)\n",
+			interval / connected, budget * 100.0f / connected, connected);
+	}
+
+	for (int b = 0; b < client_count; b++)
+	{
+		delete bots[b]->_client;
+		delete bots[b]->_transport;
+		delete bots[b]->_socket;
+		delete bots[b];
+	}
+	delete server;
+	delete server_transport;
+
+	ga_job::shutdown();
+
+	return 0;
+}
+
+static void run_bots(ga_bot** bots, int count, std::atomic_bool* running)
+{
+	static const uint32_t k_directions[] = { 0, k_button_i, k_button_j, k_button_k, k_button_l };
+	auto next = std::chrono::high_resolution_clock::now();
+	while (*running)
+	{
+		ga_frame_params params;
+		params._current_time = std::chrono::high_resolution_clock::now();
+		params._delta_time = k_tick_interval;
+		for (int b = 0; b < count; b++)
+		{
+			// Wander, picking a new direction about twice a second
+			ga_bot* bot = bots[b];
+			if (next_random(&bot->_random) % (k_tick_rate / 2) == 0)
+			{
+				bot->_buttons = k_directions[next_random(&bot->_random) % 5];
+			}
+			params._button_mask = bot->_buttons;
+			bot->_client->update(&params);
+		}
+		next += k_tick_interval;
+		std::this_thread::sleep_until(next);
+	}
+}
+
+static uint32_t next_random(uint32_t* state)
+{
+	// xorshift32
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static float percentile(std::vector<float>& samples, float fraction)
+{
+	if (samples.empty())
+	{
+		return 0.0f;
+	}
+	size_t index = (size_t)(fraction * (samples.size() - 1));
+	std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+	return samples[index];
+}